@@ -163,7 +163,11 @@ int main(int argc, char* argv[]) {
       if (decompress) {
           fsst_decoder_t decoder;
           size_t hdr = fsst_import(&decoder, srcBuf[swap]);
+#ifdef FSST12
           dstLen[swap] = fsst_decompress(&decoder, srcLen[swap] - hdr, srcBuf[swap] + hdr, FSST_MEMBUF, dstBuf[swap] = dstMem[swap]);
+#else
+          dstLen[swap] = fsst_decompress_wide(&decoder, srcLen[swap] - hdr, srcBuf[swap] + hdr, FSST_MEMBUF, dstBuf[swap] = dstMem[swap]);
+#endif
       } else {
          unsigned char tmp[FSST_MAXHEADER];
          fsst_encoder_t* encoder = fsst_create(1, &srcLen[swap], const_cast<const unsigned char **>(&srcBuf[swap]), 0);
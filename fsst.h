@@ -93,6 +93,25 @@ fsst_create(
    int zeroTerminated       /* IN: whether input strings are zero-terminated. If so, encoded strings are as well (i.e. symbol[0]=""). */
 );
 
+/* Symbol table construction options for fsst_create_ex(). Zero all fields for the defaults of fsst_create(). */
+typedef struct {
+   int zeroTerminated;      /* whether input strings are zero-terminated (see fsst_create()). */
+   int orderPreserving;     /* if set, compressed strings sort (memcmp, shorter-is-smaller) like the originals, at some loss of ratio. */
+   double gainThreshold;    /* stop training (normally 5 rounds) once a round improves the compression gain by less than this fraction, */
+                            /* e.g. 0.01 (1%). This speeds up fsst_create_ex() on regular data. 0 always does all rounds. */
+   int autotune;            /* if set, time the compression kernels on the sample (fsst_create_ex() takes 2-3x as long), and let */
+                            /* fsst_compress() use the fastest if it clearly beats the heuristic choice (by 10%, or 30% to replace SIMD by scalar). */
+} fsst_options_t;
+
+/* Calibrate a FSST symboltable from a batch of strings, with construction options. */
+fsst_encoder_t*
+fsst_create_ex(
+   size_t n,         /* IN: number of strings in batch to sample from. */
+   const size_t lenIn[],   /* IN: byte-lengths of the inputs */
+   const unsigned char *strIn[],  /* IN: string start pointers. */
+   const fsst_options_t *options  /* IN: construction options (NULL means all defaults). */
+);
+
 /* Create another encoder instance, necessary to do multi-threaded encoding using the same symbol table. */ 
 fsst_encoder_t*    
 fsst_duplicate(
@@ -101,6 +120,19 @@ fsst_duplicate(
 
 #define FSST_MAXHEADER (8+1+8+2048+1) /* maxlen of deserialized fsst header, produced/consumed by fsst_export() resp. fsst_import() */
 
+/* The number of training rounds that fsst_create() or fsst_create_ex() used for the symbol table (see gainThreshold). */
+unsigned int 
+fsst_training_rounds(
+   fsst_encoder_t *encoder  /* IN: the symbol table to inspect. */
+);
+
+/* The name of the compression kernel that fsst_compress() uses with this encoder for large batches, e.g. "avx512-unroll3" or */
+/* "scalar-avoidBranch" (small batches always use a scalar one). With autotune, it may be the fastest on the sample. */
+const char*
+fsst_kernel_name(
+   fsst_encoder_t *encoder  /* IN: the symbol table to inspect. */
+);
+
 /* Space-efficient symbol table serialization (smaller than sizeof(fsst_decoder_t) - by saving on the unused bytes in symbols of len < 8). */
 unsigned int                /* OUT: number of bytes written in buf, at most sizeof(fsst_decoder_t) */
 fsst_export(
@@ -139,6 +171,31 @@ fsst_compress(
    unsigned char *strOut[]  /* OUT: output string start pointers. Will all point into [output,output+size). */
 );
 
+/* Compress a batch of strings stored as one data buffer plus n+1 offsets (string i is [offsetsIn[i],offsetsIn[i+1]) in dataIn), */
+/* into the same layout: compressed string i is [offsetsOut[i],offsetsOut[i+1]) in output, with offsetsOut[0]=0. */
+size_t                      /* OUT: the number of compressed strings (<=n) that fit the output buffer. */ 
+fsst_compress_offsets32(
+   fsst_encoder_t *encoder, /* IN: encoder obtained from fsst_create(). */
+   size_t nstrings,         /* IN: number of strings in batch to compress. */
+   const unsigned int offsetsIn[], /* IN: nstrings+1 start offsets of the inputs in dataIn (the last one is the end). */
+   const unsigned char *dataIn, /* IN: the input strings, one after the other. */
+   size_t outsize,          /* IN: byte-length of output buffer. */
+   unsigned char *output,   /* OUT: memory buffer to put the compressed strings in (one after the other). */
+   unsigned int offsetsOut[] /* OUT: nstrings+1 start offsets of the compressed strings in output. */
+);
+
+/* Same as fsst_compress_offsets32(), with 64-bits offsets. */
+size_t
+fsst_compress_offsets64(
+   fsst_encoder_t *encoder,
+   size_t nstrings,
+   const unsigned long long offsetsIn[],
+   const unsigned char *dataIn,
+   size_t outsize,
+   unsigned char *output,
+   unsigned long long offsetsOut[]
+);
+
 /* Decompress a single string, inlined for speed. */
 inline size_t /* OUT: bytesize of the decompressed string. If > size, the decoded output is truncated to size. */
 fsst_decompress(
@@ -177,7 +234,7 @@ fsst_decompress(
          }
       }
    }
-   if (posOut+24 <= size) { // handle the possibly 3 last bytes without a loop
+   if (posOut+24 <= size && posIn+4 > lenIn) { // handle the possibly 3 last bytes without a loop
       if (posIn+2 <= lenIn) { 
 	 strOut[posOut] = strIn[posIn+1]; 
          if (strIn[posIn] != FSST_ESC) {
@@ -221,6 +278,295 @@ fsst_decompress(
    return posOut; /* full size of decompressed string (could be >size, then the actually decompressed part) */
 }
 
+/* Predicate on compressed strings, evaluated code-by-code without decompression. Use fsst_matcher_destroy() to free. */
+typedef void* fsst_matcher_t; /* opaque type - it wraps a byte-level automaton lifted to FSST codes (~1KB per automaton state, 512 bytes above 32K states) */
+
+/* Create a matcher for LIKE '%needle%', i.e. whether a string contains needle as a substring. */
+fsst_matcher_t*             /* OUT: NULL if the needle is too long (>= 65535 bytes). */
+fsst_matcher_substring(
+   const fsst_decoder_t *decoder, /* IN: symbol table of the compressed strings that will be matched. */
+   size_t len,              /* IN: byte-length of the needle. */
+   const unsigned char *needle /* IN: the (uncompressed) needle. */
+);
+
+/* Create a matcher for a regular expression, which is compiled into a DFA (returns NULL on syntax errors or too many states). */
+/* Syntax: bytes, '.', [a-z] and [^a-z] classes, escapes \d \w \s, (..), |, * + ?, and ^ or $ to anchor at the start or end. */
+fsst_matcher_t*             /* OUT: NULL if the regular expression cannot be compiled. */
+fsst_matcher_regex(
+   const fsst_decoder_t *decoder, /* IN: symbol table of the compressed strings that will be matched. */
+   const char *regex        /* IN: zero-terminated regular expression. Unless anchored, it may match anywhere in the string. */
+);
+
+/* Create a matcher from a byte-level DFA with start state 0. A string matches if the DFA ends in an accepting state. */
+fsst_matcher_t*             /* OUT: NULL if nStates is 0 or larger than 65535, or if next[] contains an invalid state. */
+fsst_matcher_dfa(
+   const fsst_decoder_t *decoder, /* IN: symbol table of the compressed strings that will be matched. */
+   unsigned int nStates,    /* IN: number of DFA states. */
+   const unsigned int next[], /* IN: transition table of nStates*256 entries: next[state*256+byte] is the next state. */
+   const unsigned char accepting[] /* IN: accepting[state] is nonzero for accepting states. */
+);
+
+/* Evaluate a matcher on a single compressed string. */
+int                         /* OUT: 1 if the string matches, 0 otherwise. */
+fsst_matcher_match(
+   const fsst_matcher_t *matcher, /* IN: matcher created for the symbol table of this string. */
+   size_t lenIn,            /* IN: byte-length of compressed string. */
+   const unsigned char *strIn /* IN: compressed string. */
+);
+
+/* Evaluate a matcher on a batch of compressed strings. */
+size_t                      /* OUT: the number of matching strings. */
+fsst_matcher_match_batch(
+   const fsst_matcher_t *matcher, /* IN: matcher created for the symbol table of these strings. */
+   size_t n,                /* IN: number of strings in batch. */
+   const size_t lenIn[],    /* IN: byte-lengths of compressed strings. */
+   const unsigned char *strIn[], /* IN: compressed string start pointers. */
+   size_t selOut[]          /* OUT: positions in the batch of the matching strings (ascending), at most n. */
+);
+
+/* Deallocate matcher. */
+void
+fsst_matcher_destroy(fsst_matcher_t*);
+
+/* Test whether a compressed string starts with a prefix (LIKE 'prefix%'). Decodes only the codes that cover the prefix. */
+int                         /* OUT: 1 if the string starts with prefix, 0 otherwise. */
+fsst_prefix_match(
+   const fsst_decoder_t *decoder, /* IN: use this symbol table for decompression. */
+   size_t lenIn,            /* IN: byte-length of compressed string. */
+   const unsigned char *strIn, /* IN: compressed string. */
+   size_t len,              /* IN: byte-length of the prefix. */
+   const unsigned char *prefix /* IN: the (uncompressed) prefix. */
+);
+
+/* Test a batch of compressed strings for a prefix (LIKE 'prefix%'). */
+size_t                      /* OUT: the number of strings that start with prefix. */
+fsst_prefix_match_batch(
+   const fsst_decoder_t *decoder, /* IN: use this symbol table for decompression. */
+   size_t n,                /* IN: number of strings in batch. */
+   const size_t lenIn[],    /* IN: byte-lengths of compressed strings. */
+   const unsigned char *strIn[], /* IN: compressed string start pointers. */
+   size_t len,              /* IN: byte-length of the prefix. */
+   const unsigned char *prefix, /* IN: the (uncompressed) prefix. */
+   size_t selOut[]          /* OUT: positions in the batch of the matching strings (ascending), at most n. */
+);
+
+/* Hash a batch of strings, intended for compressed strings (which are equal iff the originals are, given the same symbol table). */
+/* Joins and aggregations can then keep compressed strings in their hash tables. Hashes are only comparable within a symbol table. */
+void
+fsst_hash_batch(
+   size_t n,                /* IN: number of strings in batch. */
+   const size_t lenIn[],    /* IN: byte-lengths of the (compressed) strings. */
+   const unsigned char *strIn[], /* IN: string start pointers. */
+   unsigned long long hashOut[] /* OUT: 64-bits hash of each string. */
+);
+
+/* Extract normalized sort keys: the first keyLen (8 or 16) decompressed bytes, zero-padded, as big-endian integers. */
+/* Integer order of the keys (first word first) is memcmp order of the strings, except among equal keys with a tie flag set. */
+size_t                      /* OUT: the number of strings with a tie flag. */
+fsst_extract_prefix_keys(
+   const fsst_decoder_t *decoder, /* IN: use this symbol table for decompression. */
+   size_t n,                /* IN: number of strings in batch. */
+   const size_t lenIn[],    /* IN: byte-lengths of compressed strings. */
+   const unsigned char *strIn[], /* IN: compressed string start pointers. */
+   size_t keyLen,           /* IN: key byte-length: 8 (one word per string) or 16 (two words per string). */
+   unsigned long long keysOut[], /* OUT: the keys (n*keyLen/8 words). */
+   unsigned char tiesOut[]  /* OUT: 1 if the key does not decide the order of the string (longer than the key, or trailing zeros). */
+);
+
+/* Compute the decompressed byte-lengths of a batch of strings without decompressing them (e.g. to lay out the output buffer). */
+size_t                      /* OUT: the sum of the decompressed lengths. */
+fsst_decompressed_length_batch(
+   const fsst_decoder_t *decoder, /* IN: use this symbol table for decompression. */
+   size_t n,                /* IN: number of strings in batch. */
+   const size_t lenIn[],    /* IN: byte-lengths of compressed strings. */
+   const unsigned char *strIn[], /* IN: compressed string start pointers. */
+   size_t lenOut[]          /* OUT: decompressed byte-length of each string. */
+);
+
+/* Decompress a batch of strings stored as one data buffer plus n+1 offsets, into the same layout (offsetsOut[0]=0). */
+size_t                      /* OUT: the number of decompressed strings (<=n) that fit the output buffer. */
+fsst_decompress_offsets32(
+   const fsst_decoder_t *decoder, /* IN: use this symbol table for decompression. */
+   size_t n,                /* IN: number of strings in batch. */
+   const unsigned int offsetsIn[], /* IN: n+1 start offsets of the compressed strings in dataIn (the last one is the end). */
+   const unsigned char *dataIn, /* IN: the compressed strings, one after the other. */
+   size_t size,             /* IN: byte-length of output buffer. */
+   unsigned char *output,   /* OUT: memory buffer to put the decompressed strings in (one after the other). */
+   unsigned int offsetsOut[] /* OUT: n+1 start offsets of the decompressed strings in output. */
+);
+
+/* Same as fsst_decompress_offsets32(), with 64-bits offsets. */
+size_t
+fsst_decompress_offsets64(
+   const fsst_decoder_t *decoder,
+   size_t n,
+   const unsigned long long offsetsIn[],
+   const unsigned char *dataIn,
+   size_t size,
+   unsigned char *output,
+   unsigned long long offsetsOut[]
+);
+
+/* Decompress selected strings (e.g. the rows that passed a filter) of a column stored as data buffer plus offsets. */
+/* The compressed bytes of upcoming rows are prefetched while decoding, which hides memory latency on large columns. */
+size_t                      /* OUT: the number of decompressed strings (<=nsel) that fit the output buffer. */
+fsst_decompress_selected32(
+   const fsst_decoder_t *decoder, /* IN: use this symbol table for decompression. */
+   const unsigned int sel[],  /* IN: the (ascending or not) row numbers to decompress. */
+   size_t nsel,             /* IN: number of selected rows. */
+   const unsigned int offsetsIn[], /* IN: start offsets of the compressed rows in dataIn (row i ends at offsetsIn[i+1]). */
+   const unsigned char *dataIn, /* IN: the compressed rows, one after the other. */
+   size_t size,             /* IN: byte-length of output buffer. */
+   unsigned char *output,   /* OUT: memory buffer to put the decompressed strings in (one after the other). */
+   unsigned int offsetsOut[] /* OUT: nsel+1 start offsets of the decompressed strings in output. */
+);
+
+/* Same as fsst_decompress_selected32(), with 64-bits row numbers and offsets. */
+size_t
+fsst_decompress_selected64(
+   const fsst_decoder_t *decoder,
+   const unsigned long long sel[],
+   size_t nsel,
+   const unsigned long long offsetsIn[],
+   const unsigned char *dataIn,
+   size_t size,
+   unsigned char *output,
+   unsigned long long offsetsOut[]
+);
+
+/* Decompress a batch of independent strings (e.g. point lookups), each into its own buffer, like fsst_decompress() would. */
+/* The strings are decoded interleaved, a cache line at a time, so that the memory accesses of several strings overlap. */
+void
+fsst_decompress_interleaved(
+   const fsst_decoder_t *decoder, /* IN: use this symbol table for decompression. */
+   size_t n,                /* IN: number of strings in batch. */
+   const size_t lenIn[],    /* IN: byte-lengths of compressed strings. */
+   const unsigned char *strIn[], /* IN: compressed string start pointers. */
+   const size_t size[],     /* IN: byte-lengths of the output buffers. */
+   unsigned char *output[], /* OUT: the output buffers. */
+   size_t lenOut[]          /* OUT: decompressed byte-length of each string. If > size[i], output[i] holds a truncated string. */
+);
+
+typedef void* fsst_pair_decoder_t; /* opaque type - a decoder with precomputed output for frequent code pairs (~128KB + 16B per code and pair) */
+
+/* Create a pair decoder: the most frequent code pairs in a sample of compressed strings get their 16-byte output precomputed. */
+fsst_pair_decoder_t*
+fsst_pair_decoder_create(
+   const fsst_decoder_t *decoder, /* IN: use this symbol table for decompression. */
+   size_t n,                /* IN: number of strings in the sample. */
+   const size_t lenIn[],    /* IN: byte-lengths of the (compressed) sample strings. */
+   const unsigned char *strIn[], /* IN: compressed sample string start pointers. */
+   size_t maxPairs          /* IN: maximum number of pair entries (at most 1792; e.g. 1024 keeps the entries in 20KB). */
+);
+
+/* Decompress a single string with a pair decoder, emitting two codes per step where it can. Same result as fsst_decompress(). */
+size_t                      /* OUT: bytesize of the decompressed string. If > size, the decoded output is truncated to size. */
+fsst_pair_decompress(
+   const fsst_pair_decoder_t *decoder, /* IN: pair decoder obtained from fsst_pair_decoder_create(). */
+   size_t lenIn,            /* IN: byte-length of compressed string. */
+   const unsigned char *strIn, /* IN: compressed string. */
+   size_t size,             /* IN: byte-length of output buffer. */
+   unsigned char *output    /* OUT: memory buffer to put the decompressed string in. */
+);
+
+/* Deallocate a pair decoder. */
+void
+fsst_pair_decoder_destroy(fsst_pair_decoder_t *decoder);
+
+/* Decompress a single (long) string, like fsst_decompress(), finding escapes 64 codes at a time with SIMD compares (AVX512BW or AVX2). */
+size_t                      /* OUT: bytesize of the decompressed string. If > size, the decoded output is truncated to size. */
+fsst_decompress_wide(
+   const fsst_decoder_t *decoder, /* IN: use this symbol table for decompression. */
+   size_t lenIn,            /* IN: byte-length of compressed string. */
+   const unsigned char *strIn, /* IN: compressed string. */
+   size_t size,             /* IN: byte-length of output buffer. */
+   unsigned char *output    /* OUT: memory buffer to put the decompressed string in. */
+);
+
+/* State of a streaming decompression of a single string, that yields its decompressed bytes in chunks of bounded size. */
+typedef struct {
+   const fsst_decoder_t *decoder;  /* symbol table used for decompression. */
+   const unsigned char *strIn;     /* the compressed string. */
+   size_t lenIn;                   /* byte-length of the compressed string. */
+   size_t posIn;                   /* position of the next code in strIn. */
+   unsigned char pending[8];       /* bytes of the last decoded symbol that did not fit in the previous chunk, */
+   unsigned char pendingPos, pendingLen; /* namely pending[pendingPos,pendingLen). */
+} fsst_decode_stream_t;
+
+/* Start the streaming decompression of a compressed string. Both decoder and strIn must remain valid during the stream. */
+void
+fsst_decode_stream_init(
+   fsst_decode_stream_t *stream, /* OUT: the stream state. */
+   const fsst_decoder_t *decoder, /* IN: use this symbol table for decompression. */
+   size_t lenIn,            /* IN: byte-length of compressed string. */
+   const unsigned char *strIn /* IN: compressed string. */
+);
+
+/* Decompress the next chunk of a stream. Concatenated, the chunks are the string that fsst_decompress() would produce. */
+size_t                      /* OUT: number of bytes put in output (<=cap). 0 means the string is complete (if cap > 0). */
+fsst_decode_stream_next(
+   fsst_decode_stream_t *stream, /* IN/OUT: the stream state. */
+   size_t cap,              /* IN: byte-length of output buffer. */
+   unsigned char *output    /* OUT: memory buffer to put the next decompressed bytes in. */
+);
+
+/* A position in a compressed string where a code starts, and the position in the decompressed string where its symbol goes. */
+typedef struct {
+   unsigned long long posIn;  /* offset in the compressed string. */
+   unsigned long long posOut; /* offset in the decompressed string. */
+} fsst_checkpoint_t;
+
+/* Compute skip checkpoints for a (long) compressed string, to speed up fsst_decompress_range() on it. */
+size_t                      /* OUT: the number of checkpoints (<=max) put in checkpoints[]. */
+fsst_range_checkpoints(
+   const fsst_decoder_t *decoder, /* IN: use this symbol table for decompression. */
+   size_t lenIn,            /* IN: byte-length of compressed string. */
+   const unsigned char *strIn, /* IN: compressed string. */
+   size_t interval,         /* IN: checkpoint i is the last code that starts at or before decompressed offset (i+1)*interval. */
+   size_t max,              /* IN: capacity of checkpoints[]. */
+   fsst_checkpoint_t checkpoints[] /* OUT: the checkpoints, ascending. */
+);
+
+/* Decompress only the bytes [from,to) of a compressed string, e.g. for substr(). Decoding stops as soon as to is reached. */
+size_t                      /* OUT: the number of bytes put in output, i.e. min(to,length)-from (0 if from >= length). */
+fsst_decompress_range(
+   const fsst_decoder_t *decoder, /* IN: use this symbol table for decompression. */
+   size_t lenIn,            /* IN: byte-length of compressed string. */
+   const unsigned char *strIn, /* IN: compressed string. */
+   size_t from,             /* IN: first decompressed byte to produce. */
+   size_t to,               /* IN: end of the decompressed range (exclusive). */
+   unsigned char *output,   /* OUT: memory buffer of to-from bytes to put the decompressed range in. */
+   size_t ncheckpoints,     /* IN: number of checkpoints (0 to skip from the start of the string). */
+   const fsst_checkpoint_t checkpoints[] /* IN: ascending checkpoints from fsst_range_checkpoints(), or NULL. */
+);
+
+/* Decompress a (large) column stored as data buffer plus offsets, like fsst_decompress_offsets32(), with multiple threads. */
+/* A first pass computes the exact decompressed lengths, so each thread can decode its chunks of rows straight into place. */
+size_t                      /* OUT: the number of decompressed strings (<=n) that fit the output buffer. */
+fsst_decompress_parallel32(
+   const fsst_decoder_t *decoder, /* IN: use this symbol table for decompression. */
+   size_t n,                /* IN: number of strings. */
+   const unsigned int offsetsIn[], /* IN: n+1 start offsets of the compressed strings in dataIn (the last one is the end). */
+   const unsigned char *dataIn, /* IN: the compressed strings, one after the other. */
+   size_t size,             /* IN: byte-length of output buffer. */
+   unsigned char *output,   /* OUT: memory buffer to put the decompressed strings in (one after the other). */
+   unsigned int offsetsOut[], /* OUT: n+1 start offsets of the decompressed strings in output. */
+   unsigned int threads     /* IN: number of threads to use (including the caller), 0 for all hardware threads. */
+);
+
+/* Same as fsst_decompress_parallel32(), with 64-bits offsets. */
+size_t
+fsst_decompress_parallel64(
+   const fsst_decoder_t *decoder,
+   size_t n,
+   const unsigned long long offsetsIn[],
+   const unsigned char *dataIn,
+   size_t size,
+   unsigned char *output,
+   unsigned long long offsetsOut[],
+   unsigned int threads
+);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,231 @@
+/*
+ * C++ helpers on top of the FSST API -- header-only, so that the compiler can inline the consumer into the decoding loop
+ *
+ * ===================================================================================================================================
+ * this software is distributed under the MIT License (http://www.opensource.org/licenses/MIT):
+ *
+ * Copyright 2018-2020, CWI, TU Munich, FSU Jena
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * - The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+ * IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * You can contact the authors via the FSST source repository : https://github.com/cwida/fsst
+ * ===================================================================================================================================
+ *
+ * Operators often decompress a string only to hash, compare or copy it right away. Rather than decompressing a whole batch into an
+ * output column first, for_each_decoded() decompresses each string into a small buffer that is reused (and stays in L1), and
+ * passes it to a functor fn(i, str, len) that is inlined into the loop. Strings that do not fit the buffer get a heap buffer.
+ *
+ * Consumers that can work on pieces of a string (e.g. tokenizers) need no decompressed copy at all: symbol_iterator yields the
+ * pieces in place, i.e. the bytes of each symbol in the decoder, or an escaped byte in the compressed string itself.
+ * write_decoded() streams a batch of strings to a file descriptor (e.g. a socket) through a bounded buffer.
+ *
+ * compact_hash_table groups on string keys that are kept inline, e.g. compressed strings hashed with fsst_hash_batch(), which
+ * are equal iff the original strings are (given the same symbol table).
+ */
+#ifndef FSST_INCLUDED_HPP
+#define FSST_INCLUDED_HPP
+
+#include "fsst.h"
+#include <cstring>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace fsst {
+
+/* size of the reused decompression buffer (on the stack) */
+constexpr size_t DECODE_BUFFER = 4096;
+
+/* Decompress string i of lenIn bytes at strIn, and pass it to fn(i, str, len). buffer holds DECODE_BUFFER bytes. */
+template <typename Fn>
+inline void decode_one(const fsst_decoder_t *decoder, size_t i, size_t lenIn, const unsigned char *strIn, unsigned char *buffer, std::vector<unsigned char>& overflow, Fn& fn) {
+   size_t len = fsst_decompress(decoder, lenIn, strIn, DECODE_BUFFER, buffer);
+   if (len < DECODE_BUFFER) { /* note: a string that exactly fills the buffer may have been zero-terminated by fsst_decompress() */
+      fn(i, (const unsigned char*) buffer, len);
+   } else {
+      if (overflow.size() <= len) overflow.resize(len+1);
+      fsst_decompress(decoder, lenIn, strIn, overflow.size(), overflow.data());
+      fn(i, (const unsigned char*) overflow.data(), len);
+   }
+}
+
+/* Decompress a batch of n strings (given by lengths and pointers), calling fn(i, str, len) on each. */
+/* str points into a reused buffer: it is only valid during the call. */
+template <typename Fn>
+inline void for_each_decoded(const fsst_decoder_t *decoder, size_t n, const size_t lenIn[], const unsigned char *const strIn[], Fn&& fn) {
+   unsigned char buffer[DECODE_BUFFER];
+   std::vector<unsigned char> overflow;
+   for(size_t i=0; i<n; i++)
+      decode_one(decoder, i, lenIn[i], strIn[i], buffer, overflow, fn);
+}
+
+/* Same as for_each_decoded(), for n strings stored as a data buffer plus n+1 offsets (T is e.g. unsigned int or unsigned long long). */
+template <typename T, typename Fn>
+inline void for_each_decoded_offsets(const fsst_decoder_t *decoder, size_t n, const T offsetsIn[], const unsigned char *dataIn, Fn&& fn) {
+   unsigned char buffer[DECODE_BUFFER];
+   std::vector<unsigned char> overflow;
+   for(size_t i=0; i<n; i++)
+      decode_one(decoder, i, offsetsIn[i+1]-offsetsIn[i], dataIn+offsetsIn[i], buffer, overflow, fn);
+}
+
+/* Iterate over the decoded pieces of a compressed string, without copying: the symbol bytes of each code (in decoder->symbol[]), */
+/* or an escaped byte (in the compressed string). Concatenated, the pieces are the decompressed string. */
+class symbol_iterator {
+   const fsst_decoder_t *decoder;
+   const unsigned char *cur, *end;
+
+   public:
+   symbol_iterator(const fsst_decoder_t *decoder, size_t lenIn, const unsigned char *strIn) : decoder(decoder), cur(strIn), end(strIn+lenIn) {}
+
+   /* Get the next piece. Returns false at the end of the string. */
+   bool next(const unsigned char *&data, size_t &len) {
+      if (cur >= end) return false;
+      unsigned char code = *cur++;
+      if (code == FSST_ESC) {
+         data = cur++;
+         len = 1;
+      } else {
+         data = (const unsigned char*) &decoder->symbol[code]; /* the symbol bytes are stored in order (little-endian) */
+         len = decoder->len[code];
+      }
+      return true;
+   }
+};
+
+/* A compact hash table for grouping on string keys. The keys are stored inline, one after the other, in a single byte buffer */
+/* (4-byte length, key bytes, 4-byte count). A slot holds the high 24 bits of the hash and a 40-bits offset into that buffer. */
+/* The hashes must come from fsst_hash_batch(): the table rehashes the keys with it when it doubles (at half full). */
+class compact_hash_table {
+   std::vector<unsigned long long> slots; /* 0 is empty */
+   std::vector<unsigned char> keys;
+   size_t groups = 0;
+
+   void insert_slot(unsigned long long hash, unsigned long long offset) {
+      unsigned long long mask = slots.size() - 1, pos = hash & mask;
+      while (slots[pos]) pos = (pos + 1) & mask;
+      slots[pos] = ((hash >> 40) << 40) | offset;
+   }
+   void grow() {
+      std::vector<unsigned long long>(2 * slots.size()).swap(slots);
+      for (size_t offset = 1; offset < keys.size(); ) { /* the entries follow each other */
+         unsigned len;
+         memcpy(&len, keys.data() + offset, 4);
+         size_t lenIn = len;
+         const unsigned char *strIn = keys.data() + offset + 4;
+         unsigned long long hash;
+         fsst_hash_batch(1, &lenIn, &strIn, &hash);
+         insert_slot(hash, offset);
+         offset += 4 + len + 4;
+      }
+   }
+
+   public:
+   explicit compact_hash_table(size_t expectedGroups = 0) : slots(16) {
+      while (slots.size() < 2 * expectedGroups) slots.resize(2 * slots.size());
+      keys.push_back(0); /* offset 0 marks an empty slot */
+   }
+
+   /* Count a key (hash is its fsst_hash_batch() hash). Returns the count of the key so far, including this one. */
+   unsigned add(unsigned long long hash, unsigned len, const unsigned char *key) {
+      unsigned long long mask = slots.size() - 1, tag = hash >> 40;
+      for (unsigned long long pos = hash & mask;; pos = (pos + 1) & mask) {
+         unsigned long long slot = slots[pos];
+         if (!slot) break;
+         if ((slot >> 40) == tag) {
+            unsigned char *entry = keys.data() + (slot & ((1ull << 40) - 1));
+            unsigned entryLen, count;
+            memcpy(&entryLen, entry, 4);
+            if (entryLen == len && !memcmp(entry + 4, key, len)) {
+               memcpy(&count, entry + 4 + len, 4);
+               count++;
+               memcpy(entry + 4 + len, &count, 4);
+               return count;
+            }
+         }
+      }
+      unsigned one = 1;
+      size_t offset = keys.size();
+      keys.insert(keys.end(), (const unsigned char*) &len, (const unsigned char*) &len + 4);
+      keys.insert(keys.end(), key, key + len);
+      keys.insert(keys.end(), (const unsigned char*) &one, (const unsigned char*) &one + 4);
+      if (2 * ++groups > slots.size()) {
+         grow(); /* inserts the new key as well */
+      } else {
+         insert_slot(hash, offset);
+      }
+      return 1;
+   }
+
+   /* Call fn(key, len, count) for each group, in the order of their first occurrence. */
+   template <typename Fn>
+   void for_each(Fn&& fn) const {
+      for (size_t offset = 1; offset < keys.size(); ) {
+         unsigned len, count;
+         memcpy(&len, keys.data() + offset, 4);
+         memcpy(&count, keys.data() + offset + 4 + len, 4);
+         fn((const unsigned char*) keys.data() + offset + 4, len, count);
+         offset += 4 + len + 4;
+      }
+   }
+
+   /* The number of groups. */
+   size_t size() const { return groups; }
+   /* The memory consumption in bytes. */
+   size_t memory() const { return slots.size() * sizeof(unsigned long long) + keys.size(); }
+};
+
+#if defined(__unix__) || defined(__APPLE__)
+/* size of the staging buffer of write_decoded() (on the stack) */
+constexpr size_t WRITE_BUFFER = 65536;
+
+/* Write the decompressed strings of a batch to a file descriptor (e.g. a socket), one after the other, in WRITE_BUFFER writes. */
+/* The strings are decompressed through a bounded staging buffer (fsst_decode_stream_next), never as a whole. Note that handing */
+/* writev() the symbols in place (one iovec per symbol of at most 8 bytes) is much slower than this copy, due to per-iovec costs. */
+inline ssize_t /* OUT: the number of bytes written, or -1 on error (see errno). */
+write_decoded(int fd, const fsst_decoder_t *decoder, size_t n, const size_t lenIn[], const unsigned char *const strIn[]) {
+   unsigned char buffer[WRITE_BUFFER];
+   ssize_t total = 0;
+   size_t used = 0;
+   auto flush = [&]() {
+      for(size_t pos = 0; pos < used; ) {
+         ssize_t written = ::write(fd, buffer+pos, used-pos);
+         if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+         }
+         pos += written;
+      }
+      total += used;
+      used = 0;
+      return true;
+   };
+   for(size_t i=0; i<n; i++) {
+      if (lenIn[i]*8 >= WRITE_BUFFER-used && used && !flush()) return -1;
+      if (lenIn[i]*8 < WRITE_BUFFER-used) { /* fits for sure (a code decodes into at most 8 bytes) */
+         used += fsst_decompress(decoder, lenIn[i], strIn[i], WRITE_BUFFER-used, buffer+used);
+         continue;
+      }
+      fsst_decode_stream_t stream; /* a long string */
+      fsst_decode_stream_init(&stream, decoder, lenIn[i], strIn[i]);
+      for(size_t len; (len = fsst_decode_stream_next(&stream, WRITE_BUFFER-used, buffer+used)) != 0; )
+         if ((used += len) == WRITE_BUFFER && !flush()) return -1;
+   }
+   return flush() ? total : -1;
+}
+#endif
+
+} // namespace fsst
+
+#endif /* FSST_INCLUDED_HPP */
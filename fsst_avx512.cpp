@@ -26,6 +26,16 @@ bool fsst_hasAVX512() {
    __cpuidex(info, 0x00000007, 0);
    return (info[1]>>16)&1;
 }
+bool fsst_hasAVX512VBMI() {
+   int info[4];
+   __cpuidex(info, 0x00000007, 0);
+   return ((info[1]>>30)&1) && ((info[2]>>1)&1); // AVX512BW and AVX512VBMI
+}
+bool fsst_hasAVX512DQ() {
+   int info[4];
+   __cpuidex(info, 0x00000007, 0);
+   return ((info[1]>>16)&1) && ((info[1]>>17)&1); // AVX512F and AVX512DQ
+}
 #else
 #include <cpuid.h>
 bool fsst_hasAVX512() {
@@ -33,9 +43,21 @@ bool fsst_hasAVX512() {
     __cpuid_count(0x00000007, 0, info[0], info[1], info[2], info[3]);
    return (info[1]>>16)&1;
 }
+bool fsst_hasAVX512VBMI() {
+   int info[4];
+    __cpuid_count(0x00000007, 0, info[0], info[1], info[2], info[3]);
+   return ((info[1]>>30)&1) && ((info[2]>>1)&1); // AVX512BW and AVX512VBMI
+}
+bool fsst_hasAVX512DQ() {
+   int info[4];
+    __cpuid_count(0x00000007, 0, info[0], info[1], info[2], info[3]);
+   return ((info[1]>>16)&1) && ((info[1]>>17)&1); // AVX512F and AVX512DQ
+}
 #endif
 #else
 bool fsst_hasAVX512() { return false; }
+bool fsst_hasAVX512VBMI() { return false; }
+bool fsst_hasAVX512DQ() { return false; }
 #endif
 
 // BULK COMPRESSION OF STRINGS
@@ -70,6 +92,26 @@ bool fsst_hasAVX512() { return false; }
 // This reduces the effectiveness of unrolling, hence -O2 makes the loop perform worse than -O1 which skips this optimization. 
 // Assembly inspection confirmed that 3-way unroll with -O1 avoids needless load/stores.
 
+#if defined(__AVX512F__) && FSST_HASH_WAYS > 1
+// probe the other slots of the buckets for the lanes that did not match the first one (the first match is the longest)
+static inline __m512i fsst_probeBucket(SymbolTable &symbolTable, __m512i word, __m512i code, __mmask8 match) {
+   __m512i all_MASK = _mm512_set1_epi64(-1), all_FF = _mm512_set1_epi64(0xFF), all_ICL_FREE = _mm512_set1_epi64(FSST_ICL_FREE);
+   __m512i pos = _mm512_mullo_epi64(_mm512_and_epi64(word, _mm512_set1_epi64(0xFFFFFF)), _mm512_set1_epi64(FSST_HASH_PRIME));
+           pos = _mm512_slli_epi64(_mm512_and_epi64(_mm512_xor_epi64(pos,_mm512_srli_epi64(pos,FSST_SHIFT)), 
+                                   _mm512_set1_epi64(SymbolTable::hashTabSize-SymbolTable::hashTabWays)), 4);
+   for(u32 w=1; w<FSST_HASH_WAYS; w++) {
+      pos = _mm512_add_epi64(pos, _mm512_set1_epi64(sizeof(Symbol)));
+      __m512i icl  = _mm512_i64gather_epi64(pos, (((char*) symbolTable.hashTab) + 8), 1);
+      __m512i symb = _mm512_i64gather_epi64(pos, (((char*) symbolTable.hashTab) + 0), 1);
+      __mmask8 hit = _mm512_cmpeq_epi64_mask(symb, _mm512_and_epi64(word, _mm512_srlv_epi64(all_MASK, _mm512_and_epi64(icl, all_FF)))) &
+                     _mm512_cmplt_epi64_mask(icl, all_ICL_FREE) & ~match;
+      code  = _mm512_mask_mov_epi64(code, hit, _mm512_srli_epi64(icl, 16));
+      match = match | hit;
+   }
+   return code;
+}
+#endif
+
 size_t fsst_compressAVX512(SymbolTable &symbolTable, u8* codeBase, u8* symbolBase, SIMDjob *input, SIMDjob *output, size_t n, size_t unroll) {
    size_t processed = 0;
    // define some constants (all_x means that all 8 lanes contain 64-bits value X)
@@ -78,7 +120,11 @@ size_t fsst_compressAVX512(SymbolTable &symbolTable, u8* codeBase, u8* symbolBas
    __m512i all_MASK     = _mm512_broadcastq_epi64(_mm_set1_epi64((__m64) (u64) -1));
    __m512i all_PRIME    = _mm512_broadcastq_epi64(_mm_set1_epi64((__m64) (u64) FSST_HASH_PRIME));
    __m512i all_ICL_FREE = _mm512_broadcastq_epi64(_mm_set1_epi64((__m64) (u64) FSST_ICL_FREE));
+#if FSST_HASH_WAYS > 1
+#define    all_HASH       _mm512_set1_epi64(SymbolTable::hashTabSize-SymbolTable::hashTabWays) // bucket, i.e. its first slot
+#else
 #define    all_HASH       _mm512_srli_epi64(all_MASK, 64-FSST_HASH_LOG2SIZE)
+#endif
 #define    all_ONE        _mm512_srli_epi64(all_MASK, 63)
 #define    all_M19        _mm512_srli_epi64(all_MASK, 45)
 #define    all_M18        _mm512_srli_epi64(all_MASK, 46)
@@ -138,3 +184,76 @@ size_t fsst_compressAVX512(SymbolTable &symbolTable, u8* codeBase, u8* symbolBas
 #endif
    return processed;
 }
+
+// TOKENIZATION OF THE SAMPLE DURING SYMBOL TABLE CONSTRUCTION
+//
+// This parses the sample with the (not yet finalized) table of buildSymbolTable(), i.e. with 9-bits codes, the hashTab[] for
+// symbols of 3 and more bytes, the shortCodes[] for 2-byte symbols and the byteCodes[] for the rest. It does not count anything:
+// for each token, it stores its code at the position in codes[] where the token starts, and compressCount() counts afterwards.
+//
+// Each lane tokenizes one line (job = [end:32][cur:32]) and gets a new one when it is done. The sample must have 8 zero bytes
+// after each line, such that the 8-byte loads stay in the buffer and see the same (zero-padded) word as Symbol(cur,end) would
+// construct at the end of a line. The scatter writes 32 bits, so it also zeroes the code after the token; that one is either
+// overwritten by the next token or lies inside the token or the padding, where compressCount() never looks.
+void fsst_tokenizeAVX512(SymbolTable &symbolTable, const u8* sample, u16* codes, const u64* jobs, size_t n) {
+#ifdef __AVX512F__
+   __m512i all_MASK     = _mm512_broadcastq_epi64(_mm_set1_epi64((__m64) (u64) -1));
+   __m512i all_PRIME    = _mm512_broadcastq_epi64(_mm_set1_epi64((__m64) (u64) FSST_HASH_PRIME));
+   __m512i all_ICL_FREE = _mm512_broadcastq_epi64(_mm_set1_epi64((__m64) (u64) FSST_ICL_FREE));
+   __m512i all_CODE_BASE= _mm512_broadcastq_epi64(_mm_set1_epi64((__m64) (u64) FSST_CODE_BASE));
+#define    all_TWO        _mm512_slli_epi64(all_ONE, 1)
+#define    all_CODE_MASK  _mm512_srli_epi64(all_MASK, 64-FSST_CODE_BITS)
+#define    all_M32        _mm512_srli_epi64(all_MASK, 32)
+#define    all_SLOT       _mm512_slli_epi64(all_ONE, 4)
+   const u64 *jobsEnd = jobs+n;
+   __m512i job = _mm512_setzero_si512();
+   __mmask8 busy = 0; // lanes that are tokenizing a line
+
+   while(true) {
+      // load new jobs in the idle lanes (while there are jobs left)
+      __mmask8 load = (__mmask8) ~busy;
+      size_t left = jobsEnd-jobs, cnt = _mm_popcnt_u32((u32) load);
+      for(; cnt > left; cnt--) 
+         load &= load-1; // fewer jobs left than idle lanes
+      job = _mm512_mask_expandloadu_epi64(job, load, jobs); jobs += cnt;
+      if (!(busy |= load)) break;
+
+      __m512i cur   = _mm512_and_epi64(job, all_M32);
+      __m512i rest  = _mm512_sub_epi64(_mm512_srli_epi64(job, 32), cur); // bytes left in the line (>= 1)
+      __m512i word  = _mm512_mask_i64gather_epi64(all_MASK, busy, cur, sample, 1);
+      __m512i code  = _mm512_and_epi64(_mm512_i64gather_epi64(_mm512_and_epi64(word, all_FF), symbolTable.byteCodes, sizeof(u16)), all_CODE_MASK);
+      __m512i code2 = _mm512_and_epi64(_mm512_i64gather_epi64(_mm512_and_epi64(word, all_FFFF), symbolTable.shortCodes, sizeof(u16)), all_CODE_MASK);
+      __m512i pos   = _mm512_mullo_epi64(_mm512_and_epi64(word, all_FFFFFF), all_PRIME);
+              pos   = _mm512_slli_epi64(_mm512_and_epi64(_mm512_xor_epi64(pos,_mm512_srli_epi64(pos,FSST_SHIFT)), all_HASH), 4);
+
+      // a 2-byte symbol needs two bytes left
+      __mmask8 match2 = _mm512_cmpge_epu64_mask(code2, all_CODE_BASE) & _mm512_cmpge_epu64_mask(rest, all_TWO);
+      __m512i len   = _mm512_mask_mov_epi64(all_ONE, match2, all_TWO);
+      code = _mm512_mask_mov_epi64(code, match2, code2);
+
+      // a long symbol must be an occupied slot, fit in the rest of the line and be equal (the first match in a bucket is the longest)
+      __mmask8 match = 0;
+      for(u32 w=0; w<FSST_HASH_WAYS; w++, pos = _mm512_add_epi64(pos, all_SLOT)) {
+         __m512i icl   = _mm512_i64gather_epi64(pos, (((char*) symbolTable.hashTab) + 8), 1);
+         __m512i symb  = _mm512_i64gather_epi64(pos, (((char*) symbolTable.hashTab) + 0), 1);
+         __m512i lenW  = _mm512_srli_epi64(icl, 28);
+         __mmask8 hit  = _mm512_cmpeq_epi64_mask(symb, _mm512_and_epi64(word, _mm512_srlv_epi64(all_MASK, _mm512_and_epi64(icl, all_FF)))) &
+                         _mm512_cmplt_epi64_mask(icl, all_ICL_FREE) & _mm512_cmple_epu64_mask(lenW, rest) & ~match;
+         code  = _mm512_mask_mov_epi64(code, hit, _mm512_and_epi64(_mm512_srli_epi64(icl, 16), all_CODE_MASK));
+         len   = _mm512_mask_mov_epi64(len, hit, lenW);
+         match = match | hit;
+      }
+      _mm512_mask_i64scatter_epi32(codes, busy, cur, _mm512_cvtepi64_epi32(code), sizeof(u16));
+
+      // advance, lanes that reach the end of their line become idle
+      job  = _mm512_add_epi64(job, len);
+      busy = busy & _mm512_cmplt_epu64_mask(len, rest);
+   }
+#else
+   (void) symbolTable;
+   (void) sample;
+   (void) codes;
+   (void) jobs;
+   (void) n;
+#endif
+}
@@ -0,0 +1,589 @@
+// this software is distributed under the MIT License (http://www.opensource.org/licenses/MIT):
+//
+// Copyright 2018-2020, CWI, TU Munich, FSU Jena
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+// (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify,
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// - The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+// IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+#include "libfsst.hpp"
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#if defined(__AVX512BW__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#define FSST_PREFETCH(p) _mm_prefetch((const char*) (p), _MM_HINT_T0)
+#else
+#define FSST_PREFETCH(p) __builtin_prefetch(p)
+#endif
+#define FSST_PREFETCH_DISTANCE 16 // rows ahead: covers DRAM latency (~100ns) with rows that take a few ns to decode
+
+// DECODING COMPRESSED STRINGS
+//
+// fsst_decompress() (in fsst.h) decodes a single string. The functions here work on batches of strings, for the bulk decoding
+// that database scans do: computing decompressed sizes up front (to lay out the output) and decoding into columnar layouts.
+
+// the decompressed length of a string is the sum of the symbol lengths of its codes, where an escape plus its literal byte count 1
+static inline size_t decompressedLength(const fsst_decoder_t *decoder, size_t lenIn, const u8 *strIn) {
+   const u8 *cur = strIn, *end = strIn + lenIn;
+   size_t len = 0;
+   while (cur < end) {
+      size_t code = *cur++;
+      if (code < FSST_ESC) {
+         len += decoder->len[code];
+      } else {
+         len++; cur++; // escaped byte
+      }
+   }
+   return len;
+}
+
+#if defined(__AVX512VBMI__) && defined(__AVX512BW__)
+// the same, 64 codes at a time: the 256-entry length table (len[255]=1 for escapes) is four registers, looked up with two byte 
+// permutes and a blend on the high bit of each code. The literal bytes behind escapes are masked out, and sad_epu8 adds up.
+// Escapes are rare, and are only resolved sequentially if a block has a 255 that is a literal (i.e. directly behind an escape).
+static size_t decompressedLengthAVX512(const fsst_decoder_t *decoder, size_t n, const size_t lenIn[], const u8 *strIn[], size_t lenOut[]) {
+   u8 lenTab[256];
+   memcpy(lenTab, decoder->len, 255);
+   lenTab[255] = 1;
+   __m512i tab0 = _mm512_loadu_si512(lenTab), tab1 = _mm512_loadu_si512(lenTab+64);
+   __m512i tab2 = _mm512_loadu_si512(lenTab+128), tab3 = _mm512_loadu_si512(lenTab+192);
+   __m512i all_ESC = _mm512_set1_epi8((char) FSST_ESC), zero = _mm512_setzero_si512();
+   size_t total = 0;
+
+   for(size_t i=0; i<n; i++) {
+      const u8 *cur = strIn[i];
+      size_t left = lenIn[i];
+      u64 carry = 0; // 1 if the first byte of the next block is a literal (the previous block ended with an escape)
+      __m512i sums = zero;
+      while (left) {
+         size_t chunk = min(left, (size_t) 64);
+         __mmask64 valid = (chunk == 64) ? ~0ULL : (1ULL << chunk) - 1;
+         __m512i codes = _mm512_maskz_loadu_epi8(valid, cur); // masked load: does not touch bytes beyond the string
+         u64 esc = _mm512_mask_cmpeq_epi8_mask(valid, codes, all_ESC), lit = (esc << 1) | carry;
+         carry = esc >> 63;
+         if (esc & lit) { // a literal 255: resolve this block sequentially
+            u64 pending = lit & 1;
+            lit = 0;
+            for(size_t j=0; j<chunk; j++) {
+               if (pending) {
+                  lit |= 1ULL << j; pending = 0;
+               } else {
+                  pending = (esc >> j) & 1;
+               }
+            }
+            carry = pending;
+         }
+         __m512i lo = _mm512_permutex2var_epi8(tab0, codes, tab1); // low 7 bits of the code index 128 entries 
+         __m512i hi = _mm512_permutex2var_epi8(tab2, codes, tab3);
+         __m512i lens = _mm512_maskz_mov_epi8(valid & ~lit, _mm512_mask_blend_epi8(_mm512_movepi8_mask(codes), lo, hi));
+         sums = _mm512_add_epi64(sums, _mm512_sad_epu8(lens, zero));
+         cur += chunk; left -= chunk;
+      }
+      total += lenOut[i] = _mm512_reduce_add_epi64(sums);
+   }
+   return total;
+}
+#endif
+
+extern "C" size_t fsst_decompressed_length_batch(const fsst_decoder_t *decoder, size_t n, const size_t lenIn[], const u8 *strIn[], size_t lenOut[]) {
+#if defined(__AVX512VBMI__) && defined(__AVX512BW__)
+   if (fsst_hasAVX512VBMI())
+      return decompressedLengthAVX512(decoder, n, lenIn, strIn, lenOut);
+#endif
+   size_t total = 0;
+   for(size_t i=0; i<n; i++)
+      total += lenOut[i] = decompressedLength(decoder, lenIn[i], strIn[i]);
+   return total;
+}
+
+// decompression into a data buffer plus offsets: the strings go one after the other, and an offset array of T is half (u32) or
+// the same size (u64) as a length array, but there is no pointer array at all
+template <typename T>
+static inline size_t decompressOffsets(const fsst_decoder_t *decoder, size_t n, const T offsetsIn[], const u8 *dataIn, size_t size, u8 *output, T offsetsOut[]) {
+   size_t pos = 0;
+   size = min(size, (size_t) (T) ~(T) 0); // output offsets must fit T
+   offsetsOut[0] = 0;
+   for(size_t i=0; i<n; i++) {
+      size_t len = fsst_decompress(decoder, offsetsIn[i+1] - offsetsIn[i], dataIn + offsetsIn[i], size - pos, output + pos);
+      if (len > size - pos) return i; // output buffer full (this string got truncated)
+      offsetsOut[i+1] = (T) (pos += len);
+   }
+   return n;
+}
+
+extern "C" size_t fsst_decompress_offsets32(const fsst_decoder_t *decoder, size_t n, const u32 offsetsIn[], const u8 *dataIn, size_t size, u8 *output, u32 offsetsOut[]) {
+   return decompressOffsets(decoder, n, offsetsIn, dataIn, size, output, offsetsOut);
+}
+
+extern "C" size_t fsst_decompress_offsets64(const fsst_decoder_t *decoder, size_t n, const unsigned long long offsetsIn[], const u8 *dataIn, size_t size, u8 *output, unsigned long long offsetsOut[]) {
+   return decompressOffsets(decoder, n, offsetsIn, dataIn, size, output, offsetsOut);
+}
+
+// decompression of selected rows: the rows are scattered over a large column, so each one would be a cache miss (two, in fact:
+// its offset and its bytes). We pipeline them in software: while decoding row k, we prefetch the bytes of row k+D (whose offset
+// was prefetched D rows earlier), and the offset of row k+2D.
+template <typename T>
+static inline void prefetchRow(const T offsetsIn[], const u8 *dataIn, T row) {
+   const u8 *start = dataIn + offsetsIn[row], *end = dataIn + offsetsIn[row+1];
+   FSST_PREFETCH(start);
+   if (end > start && (((uintptr_t) start ^ (uintptr_t) (end-1)) & ~(uintptr_t) 63)) // the row crosses a cache line: also get the last one
+      FSST_PREFETCH(end - 1);
+}
+
+template <typename T>
+static inline size_t decompressSelected(const fsst_decoder_t *decoder, const T sel[], size_t nsel, const T offsetsIn[], const u8 *dataIn, size_t size, u8 *output, T offsetsOut[]) {
+   const size_t D = FSST_PREFETCH_DISTANCE;
+   size_t pos = 0;
+   size = min(size, (size_t) (T) ~(T) 0); // output offsets must fit T
+   offsetsOut[0] = 0;
+
+   for(size_t k=0; k<nsel && k<2*D; k++) 
+      FSST_PREFETCH(offsetsIn + sel[k]);
+   for(size_t k=0; k<nsel && k<D; k++) 
+      prefetchRow(offsetsIn, dataIn, sel[k]);
+   for(size_t k=0; k<nsel; k++) {
+      if (k + 2*D < nsel) FSST_PREFETCH(offsetsIn + sel[k+2*D]);
+      if (k + D < nsel) prefetchRow(offsetsIn, dataIn, sel[k+D]);
+      T row = sel[k];
+      size_t len = fsst_decompress(decoder, offsetsIn[row+1] - offsetsIn[row], dataIn + offsetsIn[row], size - pos, output + pos);
+      if (len > size - pos) return k; // output buffer full (this string got truncated)
+      offsetsOut[k+1] = (T) (pos += len);
+   }
+   return nsel;
+}
+
+extern "C" size_t fsst_decompress_selected32(const fsst_decoder_t *decoder, const u32 sel[], size_t nsel, const u32 offsetsIn[], const u8 *dataIn, size_t size, u8 *output, u32 offsetsOut[]) {
+   return decompressSelected(decoder, sel, nsel, offsetsIn, dataIn, size, output, offsetsOut);
+}
+
+extern "C" size_t fsst_decompress_selected64(const fsst_decoder_t *decoder, const unsigned long long sel[], size_t nsel, const unsigned long long offsetsIn[], const u8 *dataIn, size_t size, u8 *output, unsigned long long offsetsOut[]) {
+   return decompressSelected(decoder, sel, nsel, offsetsIn, dataIn, size, output, offsetsOut);
+}
+
+// interleaved decoding of independent strings (e.g. point lookups in a large column): every string is a cache miss, which
+// fsst_decompress() would wait for, one after the other. Instead, we keep a group of strings in flight, as a hand-rolled state 
+// machine. A step decodes the codes of one string up to the end of its current cache line (prefetching the next line first) 
+// and then moves on to the next string in the group, so that the cache misses of the group overlap.
+#define FSST_INTERLEAVE_GROUP 16
+
+struct DecodeState {
+   const u8 *cur, *end; // rest of the compressed string
+   size_t row, pos;     // which string, and how much we decompressed so far (may exceed the output size, see fsst_decompress)
+};
+
+extern "C" void fsst_decompress_interleaved(const fsst_decoder_t *decoder, size_t n, const size_t lenIn[], const u8 *strIn[], const size_t size[], u8 *output[], size_t lenOut[]) {
+   DecodeState group[FSST_INTERLEAVE_GROUP];
+   size_t active = 0, next = 0;
+
+   auto start = [&](DecodeState &s) { // start decoding the next string
+      s.row = next++;
+      s.cur = strIn[s.row];
+      s.end = s.cur + lenIn[s.row];
+      s.pos = 0;
+      FSST_PREFETCH(s.cur);
+   };
+   while (active < FSST_INTERLEAVE_GROUP && next < n)
+      start(group[active++]);
+
+   while (active) {
+      for(size_t g=0; g<active; ) {
+         DecodeState &s = group[g];
+         const u8 *stop = (const u8*) (((uintptr_t) s.cur | 63) + 1); // end of the cache line
+         if (stop < s.end) FSST_PREFETCH(stop); else stop = s.end;
+
+         u8 *out = output[s.row];
+         size_t pos = s.pos, lim = size[s.row];
+         const u8 *cur = s.cur;
+         while (cur < stop) {
+            size_t code = *cur++;
+            if (code < FSST_ESC) {
+               if (pos+8 <= lim) {
+                  memcpy(out+pos, &decoder->symbol[code], 8); // unaligned store
+               } else if (pos < lim) { // only write if there is room
+                  memcpy(out+pos, &decoder->symbol[code], min((size_t) decoder->len[code], lim-pos));
+               }
+               pos += decoder->len[code];
+            } else {
+               if (pos < lim) out[pos] = *cur; // escaped byte (may be the first byte of the next cache line)
+               cur++; pos++;
+            }
+         }
+         s.cur = cur;
+         s.pos = pos;
+         if (cur < s.end) {
+            g++; // this string is not done: go to the next one in the group
+            continue;
+         }
+         if (pos >= lim && (decoder->zeroTerminated&1)) out[lim-1] = 0;
+         lenOut[s.row] = pos;
+         if (next < n) {
+            start(s); // done: the slot gets the next string
+            g++;
+         } else {
+            s = group[--active]; // done, and no more strings: shrink the group
+         }
+      }
+   }
+}
+
+// pair decoding: for frequent code pairs (without escapes) we precompute the up to 16 bytes they decode into. The decode loop 
+// always consumes two codes per step, without branches: pairIdx[] (indexed by the next two codes as a little-endian u16) gives
+// the entry to emit. A pair without an entry of its own points to the single-code entry of its first code, and we then also emit
+// the second code (its symbol is always stored, but only counted in that case). As the input advance is constant, the loop has
+// no dependencies on table lookups other than the running output position.
+// A pairIdx[] value is entry:11, single:1, length-1:4. Entries 0..254 are the single codes, then the pairs.
+#define FSST_PAIR_MAX (2047-255)
+
+struct PairDecoder {
+   fsst_decoder_t decoder; // for the escapes and the last code
+   u16 pairIdx[65536];
+   vector<u64> entries;    // entries[2*i],entries[2*i+1] are the 16 bytes of entry i
+};
+
+extern "C" fsst_pair_decoder_t* fsst_pair_decoder_create(const fsst_decoder_t *decoder, size_t n, const size_t lenIn[], const u8 *strIn[], size_t maxPairs) {
+   PairDecoder *p = new PairDecoder();
+   p->decoder = *decoder;
+   maxPairs = min(maxPairs, (size_t) FSST_PAIR_MAX);
+
+   // code-pair histogram, following the pairs the decode loop will see (escapes break the sequence)
+   vector<u32> histo(65536, 0);
+   for(size_t i=0; i<n; i++) {
+      const u8 *cur = strIn[i], *end = cur + lenIn[i];
+      while (cur+1 < end) {
+         if (cur[0] == FSST_ESC) {
+            cur += 2;
+         } else if (cur[1] == FSST_ESC) {
+            cur += 1;
+         } else {
+            histo[cur[0] | (cur[1] << 8)]++;
+            cur += 2;
+         }
+      }
+   }
+   vector<u32> cands;
+   for(u32 pair=0; pair<65536; pair++)
+      if (histo[pair]) cands.push_back(pair);
+   size_t nPairs = min(maxPairs, cands.size());
+   partial_sort(cands.begin(), cands.begin() + nPairs, cands.end(), [&](u32 a, u32 b) { return histo[a] > histo[b] || (histo[a] == histo[b] && a < b); });
+
+   p->entries.resize(2*(255+nPairs), 0);
+   for(u32 code=0; code<255; code++) {
+      memcpy(&p->entries[2*code], &decoder->symbol[code], 8);
+      for(u32 next=0; next<256; next++)
+         p->pairIdx[code | (next << 8)] = (u16) ((code << 5) | (1 << 4) | (decoder->len[code]-1));
+   }
+   for(u32 next=0; next<256; next++)
+      p->pairIdx[FSST_ESC | (next << 8)] = 0; // escapes are handled outside the table
+   for(size_t i=0; i<nPairs; i++) {
+      u32 pair = cands[i], code1 = pair & 255, code2 = pair >> 8, entry = (u32) (255+i);
+      u32 len1 = decoder->len[code1], len2 = decoder->len[code2];
+      u8 buf[24] = {};
+      memcpy(buf, &decoder->symbol[code1], 8);
+      memcpy(buf+len1, &decoder->symbol[code2], 8);
+      memcpy(&p->entries[2*entry], buf, 16);
+      p->pairIdx[pair] = (u16) ((entry << 5) | (len1+len2-1));
+   }
+   return (fsst_pair_decoder_t*) p;
+}
+
+extern "C" size_t fsst_pair_decompress(const fsst_pair_decoder_t *pairDecoder, size_t lenIn, const u8 *strIn, size_t size, u8 *output) {
+   const PairDecoder *p = (const PairDecoder*) pairDecoder;
+   const u64 *entries = p->entries.data();
+   const u8 *len = p->decoder.len;
+   size_t posIn = 0, posOut = 0;
+   while (posOut+24 <= size && posIn+2 <= lenIn) {
+      u16 pair;
+      memcpy(&pair, strIn+posIn, 2);
+      if (((u8) pair == FSST_ESC) | ((pair >> 8) == FSST_ESC)) { // an escape: decode one code (or escaped byte) the normal way
+         posOut += fsst_decompress(&p->decoder, 1 + ((u8) pair == FSST_ESC), strIn+posIn, size-posOut, output+posOut);
+         posIn += 1 + ((u8) pair == FSST_ESC);
+         continue;
+      }
+      u32 idx = p->pairIdx[pair], code2 = pair >> 8;
+      memcpy(output+posOut, entries + 2*(idx>>5), 16); // unaligned 16-byte store
+      posOut += (idx & 15) + 1;
+      memcpy(output+posOut, &p->decoder.symbol[code2], 8); // only counted if the pair had no entry
+      posOut += len[code2] & -((idx >> 4) & 1);
+      posIn += 2;
+   }
+   // the last code, or the end of the output buffer
+   return posOut + fsst_decompress(&p->decoder, lenIn-posIn, strIn+posIn, size-posOut, output+posOut);
+}
+
+extern "C" void fsst_pair_decoder_destroy(fsst_pair_decoder_t *pairDecoder) {
+   delete (PairDecoder*) pairDecoder;
+}
+
+// wide-window decoding of long strings: instead of testing 4 codes at a time for escapes (as fsst_decompress() does), we find all
+// escapes in a 64-byte window with SIMD compares, and then decode the escape-free stretch up to the first escape 8 codes at a time
+static inline u64 escapeMask(const u8 *in) { // bit i is set iff in[i] == FSST_ESC, for i in [0,64)
+#if defined(__AVX512BW__)
+   return _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(in), _mm512_set1_epi8((char) FSST_ESC));
+#elif defined(__AVX2__)
+   __m256i esc = _mm256_set1_epi8((char) FSST_ESC);
+   u64 lo = (u32) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) in), esc));
+   u64 hi = (u32) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) (in+32)), esc));
+   return lo | (hi << 32);
+#else
+   u64 mask = 0;
+   for(u32 i=0; i<64; i++)
+      mask |= ((u64) (in[i] == FSST_ESC)) << i;
+   return mask;
+#endif
+}
+
+// the number of trailing zero bits of a nonzero word
+static inline u32 ctz64(u64 x) {
+#ifdef _MSC_VER
+   unsigned long pos;
+   _BitScanForward64(&pos, x); // <intrin.h> comes with fsst.h
+   return (u32) pos;
+#else
+   return (u32) __builtin_ctzll(x);
+#endif
+}
+
+#define FSST_WIDE_CODE(i) { u8 code = in[i]; memcpy(out, &symbol[code], 8); out += len[code]; }
+
+extern "C" size_t fsst_decompress_wide(const fsst_decoder_t *decoder, size_t lenIn, const u8 *strIn, size_t size, u8 *output) {
+   const unsigned long long *symbol = decoder->symbol;
+   const u8 *len = decoder->len;
+   size_t posIn = 0, posOut = 0;
+   while (posIn+64 <= lenIn && posOut+64*8 <= size) { // a window of 64 codes decodes into at most 512 bytes
+      const u8 *in = strIn+posIn;
+      u8 *out = output+posOut;
+      u64 escapes = escapeMask(in);
+      u32 stretch = escapes ? ctz64(escapes) : 64, i = 0;
+      for(; i+8 <= stretch; i+=8, in+=8) {
+         FSST_WIDE_CODE(0) FSST_WIDE_CODE(1) FSST_WIDE_CODE(2) FSST_WIDE_CODE(3)
+         FSST_WIDE_CODE(4) FSST_WIDE_CODE(5) FSST_WIDE_CODE(6) FSST_WIDE_CODE(7)
+      }
+      for(; i < stretch; i++, in++)
+         FSST_WIDE_CODE(0)
+      posIn += stretch;
+      posOut = out - output;
+      if (stretch < 64 && posIn+1 < lenIn) { // decompress an escaped byte
+         output[posOut++] = strIn[posIn+1];
+         posIn += 2;
+      }
+   }
+   // short strings, the tail, and the end of the output buffer
+   return posOut + fsst_decompress(decoder, lenIn-posIn, strIn+posIn, size-posOut, output+posOut);
+}
+
+// streaming decompression: we decode chunks of codes that certainly fit the output buffer with fsst_decompress(), as each code
+// produces at most 8 bytes. Only the last few bytes of the buffer are filled code by code, and the part of a symbol that does not
+// fit is kept in the stream state for the next call.
+extern "C" void fsst_decode_stream_init(fsst_decode_stream_t *stream, const fsst_decoder_t *decoder, size_t lenIn, const u8 *strIn) {
+   stream->decoder = decoder;
+   stream->strIn = strIn;
+   stream->lenIn = lenIn;
+   stream->posIn = 0;
+   stream->pendingPos = stream->pendingLen = 0;
+}
+
+extern "C" size_t fsst_decode_stream_next(fsst_decode_stream_t *stream, size_t cap, u8 *output) {
+   const fsst_decoder_t *decoder = stream->decoder;
+   const u8 *strIn = stream->strIn;
+   size_t lenIn = stream->lenIn, posIn = stream->posIn, posOut = 0;
+
+   // the rest of a symbol that did not fit last time
+   size_t pending = min((size_t) (stream->pendingLen - stream->pendingPos), cap);
+   memcpy(output, stream->pending + stream->pendingPos, pending);
+   stream->pendingPos += (u8) pending;
+   posOut += pending;
+
+   // chunks of (cap-posOut-1)/8 codes produce less than cap-posOut bytes (so fsst_decompress() never truncates nor terminates)
+   while (posIn < lenIn && posOut+8 < cap) {
+      size_t end = min(posIn + (cap-posOut-1)/8, lenIn), run = 0;
+      while (end-run > posIn && strIn[end-run-1] == FSST_ESC) run++;
+      end -= run & 1; // do not split an escape from its byte (a run of 0xFF bytes starts at a code, so it is escapes+bytes iff even)
+      if (end == posIn) break;
+      posOut += fsst_decompress(decoder, end-posIn, strIn+posIn, cap-posOut, output+posOut);
+      posIn = end;
+   }
+   // fill the last bytes code by code
+   while (posIn < lenIn && posOut < cap) {
+      u8 code = strIn[posIn++], symbol[8];
+      size_t len = 1;
+      if (code == FSST_ESC) {
+         symbol[0] = strIn[posIn++];
+      } else {
+         memcpy(symbol, &decoder->symbol[code], 8);
+         len = decoder->len[code];
+      }
+      size_t fits = min(len, cap-posOut);
+      memcpy(output+posOut, symbol, fits);
+      posOut += fits;
+      if (fits < len) {
+         memcpy(stream->pending, symbol, 8);
+         stream->pendingPos = (u8) fits;
+         stream->pendingLen = (u8) len;
+      }
+   }
+   stream->posIn = posIn;
+   return posOut;
+}
+
+// range decompression: we skip codes by summing their lengths (starting from the last checkpoint before the range, if any),
+// and then stream the range into the output buffer, which stops decoding at its end
+extern "C" size_t fsst_range_checkpoints(const fsst_decoder_t *decoder, size_t lenIn, const u8 *strIn, size_t interval, size_t max, fsst_checkpoint_t checkpoints[]) {
+   size_t posIn = 0, posOut = 0, n = 0, next = interval;
+   while (posIn < lenIn && n < max) {
+      u8 code = strIn[posIn];
+      size_t len = (code == FSST_ESC) ? 1 : decoder->len[code];
+      if (posOut + len > next) { // this code covers the checkpoint position
+         checkpoints[n].posIn = posIn;
+         checkpoints[n++].posOut = posOut;
+         next += interval;
+         continue;
+      }
+      posOut += len;
+      posIn += 1 + (code == FSST_ESC);
+   }
+   return n;
+}
+
+extern "C" size_t fsst_decompress_range(const fsst_decoder_t *decoder, size_t lenIn, const u8 *strIn, size_t from, size_t to, u8 *output, size_t ncheckpoints, const fsst_checkpoint_t checkpoints[]) {
+   size_t posIn = 0, posOut = 0;
+   if (to <= from) return 0;
+   const fsst_checkpoint_t *start = upper_bound(checkpoints, checkpoints + ncheckpoints, from, [](size_t pos, const fsst_checkpoint_t& c) { return pos < c.posOut; });
+   if (start != checkpoints) {
+      posIn = start[-1].posIn;
+      posOut = start[-1].posOut;
+   }
+   // skip to the code that covers from, 8 codes at a time while there are no escapes
+   const u8 *len = decoder->len;
+   while (posIn < lenIn) {
+      if (posIn+8 <= lenIn) {
+         u64 codes = fsst_unaligned_load(strIn+posIn), inv = ~codes; // an escape is a zero byte in inv
+         if (!((inv - 0x0101010101010101ULL) & ~inv & 0x8080808080808080ULL)) {
+            size_t skip = len[codes&255] + len[(codes>>8)&255] + len[(codes>>16)&255] + len[(codes>>24)&255] +
+                          len[(codes>>32)&255] + len[(codes>>40)&255] + len[(codes>>48)&255] + len[codes>>56];
+            if (posOut + skip <= from) {
+               posOut += skip;
+               posIn += 8;
+               continue;
+            }
+         }
+      }
+      u8 code = strIn[posIn];
+      size_t symbolLen = (code == FSST_ESC) ? 1 : len[code];
+      if (posOut + symbolLen > from) break;
+      posOut += symbolLen;
+      posIn += 1 + (code == FSST_ESC);
+   }
+   if (posIn >= lenIn) return 0;
+
+   // decode the range: the first symbol partially (as pending bytes of a stream), the rest by streaming until to
+   fsst_decode_stream_t stream;
+   fsst_decode_stream_init(&stream, decoder, lenIn, strIn);
+   u8 code = strIn[posIn];
+   if (code == FSST_ESC) {
+      stream.pending[0] = strIn[posIn+1];
+      stream.pendingLen = 1;
+   } else {
+      memcpy(stream.pending, &decoder->symbol[code], 8);
+      stream.pendingLen = len[code];
+   }
+   stream.pendingPos = (u8) (from - posOut);
+   stream.posIn = posIn + 1 + (code == FSST_ESC);
+   size_t n = 0;
+   for(size_t chunk; n < to-from && (chunk = fsst_decode_stream_next(&stream, to-from-n, output+n)) != 0; )
+      n += chunk;
+   return n;
+}
+
+// parallel decompression of a column: the compressed rows of a chunk are contiguous, so a first pass computes the exact
+// decompressed length of each chunk in one go (escapes cannot straddle rows), and a prefix sum gives each chunk its output
+// offset. The second pass then decodes the chunks straight into place, with fsst_decompress() limited to the end of the chunk so
+// that threads never write into each other's chunks. Both passes hand out chunks to the threads through a shared counter, so
+// fast threads take over the work of slow ones.
+#define FSST_PARALLEL_CHUNK 4096 // rows per work unit
+
+static void runParallel(size_t nchunks, unsigned threads, const std::function<void(size_t)>& work) {
+   std::atomic<size_t> next(0);
+   auto worker = [&]() {
+      for(size_t chunk; (chunk = next++) < nchunks; )
+         work(chunk);
+   };
+   vector<std::thread> pool;
+   for(unsigned i=1; i<min((size_t) threads, nchunks); i++)
+      pool.emplace_back(worker);
+   worker();
+   for(auto& thread : pool)
+      thread.join();
+}
+
+template <typename T>
+static size_t decompressParallel(const fsst_decoder_t *decoder, size_t n, const T offsetsIn[], const u8 *dataIn, size_t size, u8 *output, T offsetsOut[], unsigned threads) {
+   if (!threads) threads = max(1u, std::thread::hardware_concurrency());
+   size = min(size, (size_t) (T) ~(T) 0); // output offsets must fit T
+   size_t nchunks = (n + FSST_PARALLEL_CHUNK - 1) / FSST_PARALLEL_CHUNK;
+
+   // decompressed length of each chunk, and their prefix sum (chunkPos[c] is the output offset of chunk c)
+   vector<size_t> chunkPos(nchunks+1, 0);
+   runParallel(nchunks, threads, [&](size_t chunk) {
+      size_t first = chunk*FSST_PARALLEL_CHUNK, end = min(n, first+FSST_PARALLEL_CHUNK), lenIn = offsetsIn[end] - offsetsIn[first];
+      const u8 *strIn = dataIn + offsetsIn[first];
+      fsst_decompressed_length_batch(decoder, 1, &lenIn, &strIn, &chunkPos[chunk+1]); // the chunk as one string
+   });
+   size_t fit = 0; // number of chunks that fit the output buffer
+   for(; fit < nchunks && chunkPos[fit+1] <= size - chunkPos[fit]; fit++)
+      chunkPos[fit+1] += chunkPos[fit];
+
+   offsetsOut[0] = 0;
+   runParallel(fit, threads, [&](size_t chunk) {
+      size_t first = chunk*FSST_PARALLEL_CHUNK, end = min(n, first+FSST_PARALLEL_CHUNK), pos = chunkPos[chunk], chunkEnd = chunkPos[chunk+1];
+      for(size_t i=first; i<end; i++) {
+         size_t lenIn = offsetsIn[i+1] - offsetsIn[i];
+         if (i+1 < end || !(decoder->zeroTerminated&1)) {
+            pos += fsst_decompress(decoder, lenIn, dataIn + offsetsIn[i], chunkEnd - pos, output + pos);
+         } else { // the last string exactly fills the chunk, and fsst_decompress() would zero-terminate it
+            u8 buffer[4096];
+            size_t len = chunkEnd - pos;
+            if (len < sizeof(buffer)) {
+               fsst_decompress(decoder, lenIn, dataIn + offsetsIn[i], sizeof(buffer), buffer);
+               memcpy(output + pos, buffer, len);
+            } else {
+               vector<u8> large(len + 1);
+               fsst_decompress(decoder, lenIn, dataIn + offsetsIn[i], large.size(), large.data());
+               memcpy(output + pos, large.data(), len);
+            }
+            pos += len;
+         }
+         offsetsOut[i+1] = (T) pos;
+      }
+   });
+   if (fit == nchunks) return n;
+
+   // the chunk that does not fit: decompress as many of its strings as fit, one after the other
+   size_t first = fit*FSST_PARALLEL_CHUNK, base = chunkPos[fit];
+   for(size_t i=first; i<n; i++) {
+      size_t len = fsst_decompress(decoder, offsetsIn[i+1] - offsetsIn[i], dataIn + offsetsIn[i], size - base, output + base);
+      if (len > size - base) return i; // output buffer full (this string got truncated)
+      offsetsOut[i+1] = (T) (base += len);
+   }
+   return n;
+}
+
+extern "C" size_t fsst_decompress_parallel32(const fsst_decoder_t *decoder, size_t n, const u32 offsetsIn[], const u8 *dataIn, size_t size, u8 *output, u32 offsetsOut[], unsigned threads) {
+   return decompressParallel(decoder, n, offsetsIn, dataIn, size, output, offsetsOut, threads);
+}
+
+extern "C" size_t fsst_decompress_parallel64(const fsst_decoder_t *decoder, size_t n, const unsigned long long offsetsIn[], const u8 *dataIn, size_t size, u8 *output, unsigned long long offsetsOut[], unsigned threads) {
+   return decompressParallel(decoder, n, offsetsIn, dataIn, size, output, offsetsOut, threads);
+}
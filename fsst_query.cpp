@@ -0,0 +1,530 @@
+// this software is distributed under the MIT License (http://www.opensource.org/licenses/MIT):
+//
+// Copyright 2018-2020, CWI, TU Munich, FSU Jena
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+// (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify,
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// - The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+// IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+#include "libfsst.hpp"
+#include <bitset>
+#include <map>
+
+#if defined(__AVX512F__) && defined(__AVX512DQ__) && (defined(__x86_64__) || defined(_M_X64))
+#define FSST_HASH_AVX512
+#include <immintrin.h>
+#endif
+
+// QUERYING COMPRESSED STRINGS
+//
+// A compressed string is a sequence of codes, where each code stands for a symbol of 1-8 bytes. Any predicate that can be
+// evaluated by a byte-level automaton (DFA) can therefore also be evaluated on the codes: for each DFA state and each code we
+// precompute the state the DFA ends up in after consuming all bytes of the symbol of that code. Scanning a compressed string
+// then costs one table lookup per code instead of one per byte (up to 8x fewer transitions) and we never decompress it.
+// Escaped bytes (FSST_ESC followed by the literal byte) are the only case in which we need the byte-level DFA during a scan.
+
+#define FSST_MATCH_ACCEPT   1         // info[] bit: the state is accepting
+#define FSST_MATCH_FINAL    2         // info[] bit: the state is absorbing (all bytes lead back to it), so we can stop scanning
+#define FSST_MATCH_MAXSTATES 65535    // states are u16
+#ifndef FSST_MATCH_MAXLIFT
+#define FSST_MATCH_MAXLIFT  (1<<24)   // max bytes of codeNext[] (32K states). As it is as big as byteNext[], it doubles the memory
+#endif                                // of a matcher: bigger DFAs only keep byteNext[], and run the symbol bytes through it
+
+// a byte-level DFA, lifted to a DFA over FSST codes. The start state is 0.
+struct Matcher {
+   fsst_decoder_t decoder; // the symbol table (only used if codeNext[] is empty)
+   vector<u8> info;        // info[state] has FSST_MATCH_ACCEPT and FSST_MATCH_FINAL bits
+   vector<u16> byteNext;   // byte-level DFA: byteNext[(state<<8)+byte]
+   vector<u16> codeNext;   // code-level DFA: codeNext[(state<<8)+code] is the state after consuming all bytes of symbol[code]
+
+   Matcher(const fsst_decoder_t *decoder, u32 nStates) : decoder(*decoder), info(nStates), byteNext(((size_t) nStates)<<8) {}
+
+   // run the bytes of a symbol through the byte-level DFA
+   size_t step(size_t state, u32 code) const {
+      for(u32 i=0; i<decoder.len[code]; i++)
+         state = byteNext[(state<<8) + ((const u8*) &decoder.symbol[code])[i]];
+      return state;
+   }
+
+   // call after byteNext[] and the ACCEPT bits of info[] have been filled: mark the absorbing states, and derive codeNext[]
+   void lift() {
+      size_t nStates = info.size();
+      for(size_t state=0; state<nStates; state++) {
+         u32 c = 0;
+         while (c < 256 && byteNext[(state<<8) + c] == state) c++;
+         if (c == 256) info[state] |= FSST_MATCH_FINAL;
+      }
+      if (nStates*256*sizeof(u16) > FSST_MATCH_MAXLIFT) return; // too many states: save the memory of codeNext[]
+      codeNext.resize(nStates<<8);
+      for(size_t state=0; state<nStates; state++) {
+         for(u32 code=0; code<FSST_ESC; code++)
+            codeNext[(state<<8) + code] = (u16) step(state, code);
+         codeNext[(state<<8) + FSST_ESC] = (u16) state; // never used: escapes are handled with byteNext[]
+      }
+   }
+
+   int match(size_t lenIn, const u8 *strIn) const {
+      const u16 *__restrict__ codeTab = codeNext.data(), *__restrict__ byteTab = byteNext.data();
+      const u8 *__restrict__ stateInfo = info.data();
+      const u8 *cur = strIn, *end = strIn + lenIn;
+      size_t state = 0;
+      if (!codeNext.empty()) {
+         while (cur < end && !(stateInfo[state] & FSST_MATCH_FINAL)) { // early out in an absorbing state
+            size_t code = *cur++;
+            if (code < FSST_ESC) {
+               state = codeTab[(state<<8) + code];
+            } else if (cur < end) {
+               state = byteTab[(state<<8) + *cur++]; // escaped byte
+            }
+         }
+      } else {
+         while (cur < end && !(stateInfo[state] & FSST_MATCH_FINAL)) {
+            size_t code = *cur++;
+            if (code < FSST_ESC) {
+               state = step(state, (u32) code); // no code-level table: walk the bytes of the symbol
+            } else if (cur < end) {
+               state = byteTab[(state<<8) + *cur++];
+            }
+         }
+      }
+      return stateInfo[state] & FSST_MATCH_ACCEPT;
+   }
+};
+
+// substring search (LIKE '%needle%'): the Knuth-Morris-Pratt automaton of the needle, where state x means that the last x
+// bytes seen are the first x bytes of the needle. State len (the whole needle was seen) is the absorbing accepting state.
+static Matcher* makeSubstringMatcher(const fsst_decoder_t *decoder, size_t len, const u8 *needle) {
+   Matcher *m = new Matcher(decoder, (u32) len+1);
+   u16 *next = m->byteNext.data();
+   if (len) {
+      next[needle[0]] = 1;
+      for(u32 j=1, x=0; j<len; j++) { // x is the state the automaton would be in after mismatching in state j
+         for(u32 c=0; c<256; c++)
+            next[(j<<8) + c] = next[(x<<8) + c];
+         next[(j<<8) + needle[j]] = j+1;
+         x = next[(x<<8) + needle[j]];
+      }
+   }
+   for(u32 c=0; c<256; c++)
+      next[(len<<8) + c] = (u16) len; // the accepting state is absorbing
+   m->info[len] = FSST_MATCH_ACCEPT;
+   m->lift();
+   return m;
+}
+
+extern "C" fsst_matcher_t* fsst_matcher_substring(const fsst_decoder_t *decoder, size_t len, const u8 *needle) {
+   if (len >= FSST_MATCH_MAXSTATES) return NULL;
+   return (fsst_matcher_t*) makeSubstringMatcher(decoder, len, needle);
+}
+
+extern "C" fsst_matcher_t* fsst_matcher_dfa(const fsst_decoder_t *decoder, unsigned int nStates, const unsigned int next[], const u8 accepting[]) {
+   if (nStates == 0 || nStates > FSST_MATCH_MAXSTATES) return NULL;
+   for(size_t i=0; i<((size_t) nStates)<<8; i++)
+      if (next[i] >= nStates) return NULL; // invalid transition table
+   Matcher *m = new Matcher(decoder, nStates);
+   for(size_t i=0; i<((size_t) nStates)<<8; i++)
+      m->byteNext[i] = (u16) next[i];
+   for(u32 i=0; i<nStates; i++)
+      m->info[i] = accepting[i]?FSST_MATCH_ACCEPT:0;
+   m->lift();
+   return (fsst_matcher_t*) m;
+}
+
+// A small regular expression compiler: parse into a Thompson NFA, then turn it into a DFA by subset construction.
+//
+// Supported syntax: literal bytes, '.', classes [a-z0-9_] and [^...], escapes \d \w \s (\x is x otherwise), grouping (..),
+// alternation |, and the quantifiers * + ?. Like grep, the pattern matches if it occurs anywhere in the string, unless it
+// is anchored with ^ (at the very start of the pattern) and/or $ (at the very end).
+struct RegexCompiler {
+   struct State {
+      bitset<256> bytes; // for byte states: the bytes that lead to out
+      int out = -1, out1 = -1; // epsilon states have up to two outgoing edges, byte states exactly one (out)
+      bool epsilon = true;
+   };
+   vector<State> nfa;
+   const char *cur, *end;
+   bool error = false;
+
+   int newState() { nfa.emplace_back(); return (int) nfa.size()-1; }
+   void connect(int from, int to) { // add an epsilon edge
+      if (nfa[from].out < 0) nfa[from].out = to; else nfa[from].out1 = to;
+   }
+
+   typedef pair<int,int> Frag; // (start,end): end is an epsilon state without outgoing edges yet
+
+   Frag byteSet(const bitset<256> &bytes) {
+      int s = newState(), e = newState();
+      nfa[s].epsilon = false;
+      nfa[s].bytes = bytes;
+      nfa[s].out = e;
+      return Frag(s,e);
+   }
+   bitset<256> escape(u8 c) {
+      bitset<256> set;
+      auto range = [&](u8 lo, u8 hi) { for(u32 i=lo; i<=hi; i++) set.set(i); };
+      if (c == 'd') { range('0','9'); }
+      else if (c == 'w') { range('0','9'); range('a','z'); range('A','Z'); set.set('_'); }
+      else if (c == 's') { set.set(' '); range('\t','\r'); }
+      else set.set(c);
+      return set;
+   }
+   Frag parseAtom() {
+      if (cur >= end) { error = true; return Frag(0,0); }
+      u8 c = *cur++;
+      bitset<256> set;
+      if (c == '(') {
+         Frag f = parseAlt();
+         if (cur >= end || *cur++ != ')') error = true;
+         return f;
+      } else if (c == '.') {
+         set.set();
+      } else if (c == '\\') {
+         if (cur >= end) { error = true; return Frag(0,0); }
+         set = escape(*cur++);
+      } else if (c == '[') {
+         bool negate = (cur < end && *cur == '^');
+         cur += negate;
+         for(bool first = true; cur < end && (first || *cur != ']'); first = false) {
+            u8 lo = *cur++;
+            if (lo == '\\' && cur < end) {
+               set |= escape(*cur++);
+               continue;
+            }
+            u8 hi = lo;
+            if (cur+1 < end && *cur == '-' && cur[1] != ']') { hi = cur[1]; cur += 2; }
+            for(u32 i=lo; i<=hi; i++) set.set(i);
+         }
+         if (cur >= end) { error = true; return Frag(0,0); }
+         cur++; // skip ']'
+         if (negate) set.flip();
+      } else if (c == '*' || c == '+' || c == '?' || c == ')' || c == '|') {
+         error = true;
+         return Frag(0,0);
+      } else {
+         set.set(c);
+      }
+      return byteSet(set);
+   }
+   Frag parseRepeat() {
+      Frag f = parseAtom();
+      while (!error && cur < end && (*cur == '*' || *cur == '+' || *cur == '?')) {
+         char q = *cur++;
+         int s = newState(), e = newState();
+         connect(s, f.first);
+         connect(f.second, e);
+         if (q != '+') connect(s, e);  // * and ?: may skip
+         if (q != '?') connect(f.second, f.first); // * and +: may repeat
+         f = Frag(s,e);
+      }
+      return f;
+   }
+   Frag parseConcat() {
+      int s = newState();
+      Frag f(s,s);
+      while (!error && cur < end && *cur != '|' && *cur != ')') {
+         Frag g = parseRepeat();
+         connect(f.second, g.first);
+         f.second = g.second;
+      }
+      return f;
+   }
+   Frag parseAlt() {
+      Frag f = parseConcat();
+      while (!error && cur < end && *cur == '|') {
+         cur++;
+         Frag g = parseConcat();
+         int s = newState(), e = newState();
+         connect(s, f.first);
+         connect(s, g.first);
+         connect(f.second, e);
+         connect(g.second, e);
+         f = Frag(s,e);
+      }
+      return f;
+   }
+
+   // add the epsilon closure of an NFA state to a set. We only keep the byte states and the final state.
+   void closure(int state, int accept, vector<u8> &seen, vector<int> &set) {
+      if (state < 0 || seen[state]) return;
+      seen[state] = 1;
+      if (!nfa[state].epsilon || state == accept) set.push_back(state);
+      if (nfa[state].epsilon) {
+         closure(nfa[state].out, accept, seen, set);
+         closure(nfa[state].out1, accept, seen, set);
+      }
+   }
+
+   Matcher* compile(const fsst_decoder_t *decoder, const char *regex) {
+      size_t len = strlen(regex), escapes = 0;
+      bool anchorStart = (len && regex[0] == '^'), anchorEnd = (len > anchorStart && regex[len-1] == '$');
+      while (anchorEnd && len-1-escapes > anchorStart && regex[len-2-escapes] == '\\') 
+         escapes++; // the $ is escaped if it follows an odd number of backslashes
+      anchorEnd = anchorEnd && !(escapes&1);
+      cur = regex; end = regex + len;
+      cur += anchorStart;
+      end -= anchorEnd;
+      Frag f = parseAlt();
+      if (error || cur != end) return NULL;
+      int accept = f.second;
+
+      // subset construction. Unanchored at the start: the NFA start state is in every set. Unanchored at the end: any set
+      // that contains the final NFA state is accepting and absorbing.
+      map<vector<int>,u32> dfaStates;
+      vector<vector<int>> todo;
+      vector<u32> next;
+      vector<u8> accepting;
+      auto addState = [&](vector<int> &set) -> u32 {
+         sort(set.begin(), set.end());
+         auto it = dfaStates.find(set);
+         if (it != dfaStates.end()) return it->second;
+         u32 id = (u32) todo.size();
+         dfaStates[set] = id;
+         todo.push_back(set);
+         accepting.push_back(binary_search(set.begin(), set.end(), accept));
+         return id;
+      };
+      vector<u8> seen(nfa.size());
+      vector<int> set;
+      closure(f.first, accept, seen, set);
+      addState(set);
+
+      for(u32 id=0; id<todo.size(); id++) {
+         if (todo.size() > FSST_MATCH_MAXSTATES) return NULL; // too complex
+         next.resize(todo.size()<<8);
+         if (accepting[id] && !anchorEnd) { // absorbing
+            for(u32 c=0; c<256; c++) next[(id<<8) + c] = id;
+            continue;
+         }
+         for(u32 c=0; c<256; c++) {
+            fill(seen.begin(), seen.end(), 0);
+            set.clear();
+            if (!anchorStart) closure(f.first, accept, seen, set);
+            for(int s : todo[id])
+               if (!nfa[s].epsilon && nfa[s].bytes.test(c))
+                  closure(nfa[s].out, accept, seen, set);
+            u32 target = addState(set); // may grow todo, and invalidate references into it
+            next.resize(todo.size()<<8);
+            next[(id<<8) + c] = target;
+         }
+      }
+      return (Matcher*) fsst_matcher_dfa(decoder, (u32) todo.size(), next.data(), accepting.data());
+   }
+};
+
+extern "C" fsst_matcher_t* fsst_matcher_regex(const fsst_decoder_t *decoder, const char *regex) {
+   RegexCompiler compiler;
+   return (fsst_matcher_t*) compiler.compile(decoder, regex);
+}
+
+extern "C" int fsst_matcher_match(const fsst_matcher_t *matcher, size_t lenIn, const u8 *strIn) {
+   return ((const Matcher*) matcher)->match(lenIn, strIn);
+}
+
+extern "C" size_t fsst_matcher_match_batch(const fsst_matcher_t *matcher, size_t n, const size_t lenIn[], const u8 *strIn[], size_t selOut[]) {
+   const Matcher *m = (const Matcher*) matcher;
+   size_t nsel = 0;
+   for(size_t i=0; i<n; i++) {
+      selOut[nsel] = i;
+      nsel += m->match(lenIn[i], strIn[i]); // branch-free selection vector
+   }
+   return nsel;
+}
+
+extern "C" void fsst_matcher_destroy(fsst_matcher_t *matcher) {
+   delete (Matcher*) matcher;
+}
+
+// prefix match (LIKE 'prefix%'): no automaton needed. We decode only as many codes as are needed to cover the prefix and compare
+// each symbol with the next bytes of the prefix as one masked 8-byte word, stopping at the first mismatch.
+static inline int prefixMatch(const fsst_decoder_t *decoder, size_t lenIn, const u8 *strIn, size_t len, const u8 *prefix) {
+   const u8 *cur = strIn, *end = strIn + lenIn;
+   for(size_t done = 0; done < len; ) {
+      if (cur >= end) return 0; // string is shorter than the prefix
+      u64 symbol, word = 0;
+      size_t symbolLen, code = *cur++;
+      if (code < FSST_ESC) {
+         symbol = decoder->symbol[code];
+         symbolLen = decoder->len[code];
+      } else {
+         if (cur >= end) return 0;
+         symbol = *cur++; // escaped byte
+         symbolLen = 1;
+      }
+      size_t cmpLen = min(symbolLen, len-done); // symbol may extend beyond the prefix (1 <= cmpLen <= 8)
+      if (len-done >= 8) {
+         word = fsst_unaligned_load(prefix+done);
+      } else {
+         memcpy(&word, prefix+done, len-done); // do not read beyond the prefix
+      }
+      if ((symbol ^ word) & (0xFFFFFFFFFFFFFFFF >> (8*(8-cmpLen)))) return 0; // mismatch
+      done += symbolLen;
+   }
+   return 1;
+}
+
+extern "C" int fsst_prefix_match(const fsst_decoder_t *decoder, size_t lenIn, const u8 *strIn, size_t len, const u8 *prefix) {
+   return prefixMatch(decoder, lenIn, strIn, len, prefix);
+}
+
+extern "C" size_t fsst_prefix_match_batch(const fsst_decoder_t *decoder, size_t n, const size_t lenIn[], const u8 *strIn[], size_t len, const u8 *prefix, size_t selOut[]) {
+   size_t nsel = 0;
+   for(size_t i=0; i<n; i++) {
+      selOut[nsel] = i;
+      nsel += prefixMatch(decoder, lenIn[i], strIn[i], len, prefix); // branch-free selection vector
+   }
+   return nsel;
+}
+
+// hashing compressed strings: equal strings are equal in compressed form (given the same symbol table), so joins and aggregations
+// can hash (and compare) the compressed strings directly. These are short, so we mix in the length up front and read the last
+// 1-7 bytes in one go without ever reading beyond the end of the string. With AVX512, 8 strings are hashed at once (one per
+// 64-bits lane), with the same result.
+#define FSST_HASH_MULT 0xc6a4a7935bd1e995ULL
+#define FSST_HASH_SEED 0x8445d61a4e774912ULL
+
+static inline u64 hashMix(u64 h, u64 k) {
+   k *= FSST_HASH_MULT;
+   k ^= k >> 47;
+   k *= FSST_HASH_MULT;
+   h ^= k;
+   return h * FSST_HASH_MULT;
+}
+
+static inline u64 hashString(size_t len, const u8 *str) {
+   const u8 *cur = str, *end = str + len;
+   u64 h = FSST_HASH_SEED ^ (len * FSST_HASH_MULT);
+   for(; cur+8 <= end; cur += 8)
+      h = hashMix(h, fsst_unaligned_load(cur));
+   if (cur < end) {
+      size_t rest = end - cur;
+      u64 k;
+      if (len >= 8) { // re-read the last 8 bytes and shift away the ones we already hashed
+         k = fsst_unaligned_load(end-8) >> (8*(8-rest));
+      } else if (rest >= 4) { // 4-7 bytes: two (possibly overlapping) 4-byte reads
+         u32 lo, hi;
+         memcpy(&lo, cur, 4);
+         memcpy(&hi, end-4, 4);
+         k = (((u64) hi) << 32) | lo;
+      } else { // 1-3 bytes: first, middle and last byte
+         k = (((u64) cur[0]) << 16) | (((u64) cur[rest>>1]) << 8) | end[-1];
+      }
+      h = hashMix(h, k);
+   }
+   h ^= h >> 47;
+   h *= FSST_HASH_MULT;
+   return h ^ (h >> 47);
+}
+
+#ifdef FSST_HASH_AVX512
+static inline __m512i hashMix8(__m512i h, __m512i k, __m512i mult) {
+   k = _mm512_mullo_epi64(k, mult);
+   k = _mm512_xor_si512(k, _mm512_srli_epi64(k, 47));
+   k = _mm512_mullo_epi64(k, mult);
+   return _mm512_mullo_epi64(_mm512_xor_si512(h, k), mult);
+}
+
+// hashString() on 8 strings at a time: the lanes gather the next word of their string until all have less than 8 bytes left.
+// Returns the number of strings hashed (a multiple of 8).
+static size_t hashBatchAVX512(size_t n, const size_t lenIn[], const u8 *strIn[], u64 hashOut[]) {
+   static const u8 empty = 0; // read instead of the bytes of empty strings
+   const __m512i mult = _mm512_set1_epi64((long long) FSST_HASH_MULT), zero = _mm512_setzero_si512();
+   const __m512i four = _mm512_set1_epi64(4), eight = _mm512_set1_epi64(8);
+   size_t i = 0;
+   for(; i+8 <= n; i += 8) {
+      __m512i len = _mm512_loadu_si512(lenIn+i), cur = _mm512_loadu_si512(strIn+i), end = _mm512_add_epi64(cur, len);
+      __m512i h = _mm512_xor_si512(_mm512_set1_epi64((long long) FSST_HASH_SEED), _mm512_mullo_epi64(len, mult));
+      for(__mmask8 full; (full = _mm512_cmple_epu64_mask(_mm512_add_epi64(cur, eight), end)) != 0; ) {
+         __m512i k = _mm512_mask_i64gather_epi64(zero, full, cur, (const void*) 0, 1);
+         h = _mm512_mask_mov_epi64(h, full, hashMix8(h, k, mult));
+         cur = _mm512_mask_add_epi64(cur, full, cur, eight);
+      }
+      // the last 1-7 bytes, in the same three cases as hashString()
+      __m512i rest = _mm512_sub_epi64(end, cur), k = zero;
+      __mmask8 tail = _mm512_cmpneq_epu64_mask(rest, zero);
+      __mmask8 reread = tail & _mm512_cmpge_epu64_mask(len, eight);
+      __mmask8 halves = tail & ~reread & _mm512_cmpge_epu64_mask(rest, four);
+      __mmask8 bytes = tail & ~reread & ~halves;
+      if (reread) {
+         k = _mm512_mask_i64gather_epi64(zero, reread, _mm512_sub_epi64(end, eight), (const void*) 0, 1);
+         k = _mm512_srlv_epi64(k, _mm512_slli_epi64(_mm512_sub_epi64(eight, rest), 3));
+      }
+      if (halves) {
+         __m512i lo = _mm512_cvtepu32_epi64(_mm512_mask_i64gather_epi32(_mm256_setzero_si256(), halves, cur, (const void*) 0, 1));
+         __m512i hi = _mm512_cvtepu32_epi64(_mm512_mask_i64gather_epi32(_mm256_setzero_si256(), halves, _mm512_sub_epi64(end, four), (const void*) 0, 1));
+         k = _mm512_mask_mov_epi64(k, halves, _mm512_or_si512(lo, _mm512_slli_epi64(hi, 32)));
+      }
+      if (bytes) { // there are no byte gathers: read the first, middle and last byte of all 8 strings without branches
+         alignas(64) u64 word[8];
+         for(size_t l=0; l<8; l++) {
+            size_t strLen = lenIn[i+l] ? lenIn[i+l] : 1;
+            const u8 *str = lenIn[i+l] ? strIn[i+l] : &empty;
+            word[l] = (((u64) str[0]) << 16) | (((u64) str[strLen>>1]) << 8) | str[strLen-1];
+         }
+         k = _mm512_mask_mov_epi64(k, bytes, _mm512_load_si512(word));
+      }
+      h = _mm512_mask_mov_epi64(h, tail, hashMix8(h, k, mult));
+      h = _mm512_xor_si512(h, _mm512_srli_epi64(h, 47));
+      h = _mm512_mullo_epi64(h, mult);
+      _mm512_storeu_si512(hashOut+i, _mm512_xor_si512(h, _mm512_srli_epi64(h, 47)));
+   }
+   return i;
+}
+#endif
+
+extern "C" void fsst_hash_batch(size_t n, const size_t lenIn[], const u8 *strIn[], unsigned long long hashOut[]) {
+   size_t i = 0;
+#ifdef FSST_HASH_AVX512
+   if (fsst_hasAVX512DQ())
+      i = hashBatchAVX512(n, lenIn, strIn, (u64*) hashOut);
+#endif
+   for(; i<n; i++) // the iterations are independent, so the out-of-order CPU overlaps the multiply chains of several strings
+      hashOut[i] = hashString(lenIn[i], strIn[i]);
+}
+
+// normalized sort keys: the first 8 or 16 decoded bytes of a string, zero-padded and byte-swapped, so that comparing the keys as
+// unsigned integers (most significant word first) orders strings like memcmp on those bytes. We decode only the first few codes.
+// The key alone does not decide the order of a string that is longer than the key, or that ends in zero bytes (it then looks
+// like a shorter string with padding): such strings get a tie flag, and only pairs with equal keys of which one is flagged need
+// a full comparison.
+static inline u8 extractPrefixKey(const fsst_decoder_t *decoder, size_t lenIn, const u8 *strIn, size_t keyLen, u64 *keyOut) {
+   const u8 *cur = strIn, *end = strIn + lenIn;
+   u8 buf[16+8+8] = {}; // a symbol store may start at byte keyLen-1 and always writes 8 bytes
+   size_t pos = 0;
+   while (pos < keyLen && cur < end) {
+      size_t code = *cur++;
+      if (code < FSST_ESC) {
+         memcpy(buf+pos, &decoder->symbol[code], 8); // little-endian symbol bytes, unaligned store
+         pos += decoder->len[code];
+      } else if (cur < end) {
+         buf[pos++] = *cur++; // escaped byte
+      }
+   }
+   for(size_t i=0; i<keyLen/8; i++)
+      keyOut[i] = fsst_ordered_key(buf+8*i, 8);
+   if (pos < keyLen) {
+      return pos && !buf[pos-1]; // short string: the key is exact, unless zero bytes at the end hide in the padding
+   }
+   return (pos > keyLen) || (cur < end) || !buf[keyLen-1];
+}
+
+extern "C" size_t fsst_extract_prefix_keys(const fsst_decoder_t *decoder, size_t n, const size_t lenIn[], const u8 *strIn[], size_t keyLen, unsigned long long keysOut[], u8 tiesOut[]) {
+   size_t ties = 0, words = (keyLen > 8) ? 2 : 1;
+   keyLen = 8*words;
+   for(size_t i=0; i<n; i++) {
+      u64 key[2];
+      u8 tie = extractPrefixKey(decoder, lenIn[i], strIn[i], keyLen, key);
+      keysOut[i*words] = key[0];
+      if (words > 1) keysOut[i*words+1] = key[1];
+      tiesOut[i] = tie;
+      ties += tie;
+   }
+   return ties;
+}
@@ -26,12 +26,13 @@ Symbol concat(Symbol a, Symbol b) {
    return s;
 }
 
-namespace std {
-template <>
-class hash<QSymbol> {
-   public:
-   size_t operator()(const QSymbol& q) const {
-      uint64_t k = q.symbol.val.num;
+// flat open-addressing hash table of candidate symbols (keyed on val.num and length), reused across the rounds of buildSymbolTable()
+// the candidates are kept in insertion order in a vector, the slots refer to them. Clearing only resets the slots that were used.
+class CandidateTable {
+   vector<u32> slots; // 1 + index in cands, 0 is empty
+   vector<u32> used;  // slots in use (to clear them)
+
+   static size_t hash(u64 k) {
       const uint64_t m = 0xc6a4a7935bd1e995;
       const int r = 47;
       uint64_t h = 0x8445d61a4e774912 ^ (8*m);
@@ -45,8 +46,47 @@ class hash<QSymbol> {
       h ^= h >> r;
       return h;
    }
+   void insertSlot(u32 index) {
+      size_t mask = slots.size()-1;
+      for(size_t pos = hash(cands[index].symbol.val.num) & mask; ; pos = (pos+1) & mask) {
+         if (!slots[pos]) {
+            slots[pos] = index+1;
+            used.push_back((u32) pos);
+            return;
+         }
+      }
+   }
+
+   public:
+   vector<QSymbol> cands;
+
+   CandidateTable() : slots(4096, 0) {}
+   void clear() {
+      for(u32 pos : used) slots[pos] = 0;
+      used.clear();
+      cands.clear();
+   }
+   void addOrInc(Symbol s, u32 gain) {
+      size_t mask = slots.size()-1;
+      for(size_t pos = hash(s.val.num) & mask; slots[pos]; pos = (pos+1) & mask) {
+         QSymbol &q = cands[slots[pos]-1];
+         if (q.symbol.val.num == s.val.num && q.symbol.length() == s.length()) {
+            q.gain += gain;
+            return;
+         }
+      }
+      cands.push_back(QSymbol{s, gain});
+      if (2*cands.size() > slots.size()) { // keep the load factor below 1/2
+         for(u32 pos : used) slots[pos] = 0;
+         used.clear();
+         slots.assign(2*slots.size(), 0);
+         for(u32 index=0; index<cands.size(); index++)
+            insertSlot(index);
+      } else {
+         insertSlot((u32) (cands.size()-1));
+      }
+   }
 };
-}
 
 bool isEscapeCode(u16 pos) { return pos < FSST_CODE_BASE; }
 
@@ -56,7 +96,7 @@ std::ostream& operator<<(std::ostream& out, const Symbol& s) {
    return out;
 }
 
-SymbolTable *buildSymbolTable(Counters& counters, vector<const u8*> line, const size_t len[], bool zeroTerminated=false) {
+SymbolTable *buildSymbolTable(Counters& counters, vector<const u8*> line, const size_t len[], bool zeroTerminated=false, double gainThreshold=0, u32 *rounds=nullptr) {
    SymbolTable *st = new SymbolTable(), *bestTable = new SymbolTable();
    int bestGain = (int) -FSST_SAMPLEMAXSZ; // worst case (everything exception)
    size_t sampleFrac = 128;
@@ -85,8 +125,75 @@ SymbolTable *buildSymbolTable(Counters& counters, vector<const u8*> line, const
    // a random number between 0 and 128
    auto rnd128 = [&](size_t i) { return 1 + (FSST_HASH((i+1UL)*sampleFrac)&127); };
 
+   // with AVX512, the sample is tokenized by fsst_tokenizeAVX512() into codes[] first, and counted afterwards (see countTokens)
+   // it needs a copy of the sample with 8 zero bytes after each (non-empty) line, so the end of a line needs no special case
+#ifdef __AVX512F__
+   bool simd = fsst_hasAVX512();
+#else
+   bool simd = false; // fsst_tokenizeAVX512() is empty when the library is built without AVX512
+#endif
+   vector<u32> offset;
+   vector<u8> text;
+   vector<u16> codes; // codes[x] is the code of the token that starts at text[x]
+   vector<u64> jobs;  // the lines to tokenize in a round, as [end:32][cur:32] offsets in text[]
+   if (simd) {
+      size_t sampleSize = 0;
+      offset.resize(line.size());
+      for(size_t i=0; i<line.size(); i++) {
+         offset[i] = (u32) sampleSize;
+         if (len[i]) sampleSize += len[i] + 8;
+      }
+      text.resize(sampleSize, 0);
+      codes.resize(sampleSize);
+      jobs.reserve(line.size());
+      for(size_t i=0; i<line.size(); i++) 
+         memcpy(text.data() + offset[i], line[i], len[i]);
+   }
+
+   // count the tokens in codes[] of the lines in jobs[], exactly like compressCount() does while tokenizing (returns gain)
+   auto countTokens = [&](SymbolTable *st, Counters &counters) { 
+      int gain = 0;
+      for(u64 job : jobs) {
+         u32 pos = (u32) job, end = (u32) (job >> 32);
+         u16 code1 = codes[pos];
+         u32 len1 = st->symbols[code1].length();
+         gain += (int) (len1-(1+isEscapeCode(code1)));
+         while (true) {
+            counters.count1Inc(code1);
+            if (len1 != 1) 
+               counters.count1Inc(text[pos]);
+            if ((pos += len1) == end) 
+               break;
+
+            u16 code2 = codes[pos];
+            u32 len2 = st->symbols[code2].length();
+            gain += (int) (len2-(1+isEscapeCode(code2)));
+            if (sampleFrac < 128) { 
+               counters.count2Inc(code1, code2);
+               if (len2 > 1)
+                  counters.count2Inc(code1, text[pos]);
+            }
+            code1 = code2;
+            len1 = len2;
+         }
+      }
+      return gain;
+   };
+
    // compress sample, and compute (pair-)frequencies
+   size_t sampled = 0; // bytes compressed by compressCount() in this round
    auto compressCount = [&](SymbolTable *st, Counters &counters) { // returns gain
+      sampled = 0;
+      if (simd) {
+         jobs.clear();
+         for(size_t i=0; i<line.size(); i++) 
+            if (len[i] && (sampleFrac >= 128 || rnd128(i) <= sampleFrac)) {
+               jobs.push_back(((u64) (offset[i] + len[i]) << 32) | offset[i]);
+               sampled += len[i];
+            }
+         fsst_tokenizeAVX512(*st, text.data(), codes.data(), jobs.data(), jobs.size());
+         return countTokens(st, counters);
+      }
       int gain = 0;
 
       for(size_t i=0; i<line.size(); i++) {
@@ -97,6 +204,7 @@ SymbolTable *buildSymbolTable(Counters& counters, vector<const u8*> line, const
             // in earlier rounds (sampleFrac < 128) we skip data in the sample (reduces overall work ~2x)
             if (rnd128(i) > sampleFrac) continue;
          }
+         sampled += len[i];
          if (cur < end) {
             u16 code2 = 255, code1 = st->findLongestSymbol(cur, end);
             cur += st->symbols[code1].length();
@@ -119,7 +227,7 @@ SymbolTable *buildSymbolTable(Counters& counters, vector<const u8*> line, const
                   u64 word = fsst_unaligned_load(cur);
                   size_t code = word & 0xFFFFFF;
                   size_t idx = FSST_HASH(code)&(st->hashTabSize-1);
-                  Symbol s = st->hashTab[idx];
+                  Symbol s = st->hashProbe(idx, word);
                   code2 = st->shortCodes[word & 0xFFFF] & FSST_CODE_MASK;
                   word &= (0xFFFFFFFFFFFFFFFF >> (u8) s.icl);
                   if ((s.icl < FSST_ICL_FREE) & (s.val.num == word)) {
@@ -154,25 +262,18 @@ SymbolTable *buildSymbolTable(Counters& counters, vector<const u8*> line, const
       return gain; 
    };
 
+   CandidateTable cands; // hashmap of candidates (needed because we can generate duplicate candidates)
+
    auto makeTable = [&](SymbolTable *st, Counters &counters) {
-      // hashmap of c (needed because we can generate duplicate candidates)
-      unordered_set<QSymbol> cands;
+      cands.clear();
 
       // artificially make terminater the most frequent symbol so it gets included
       u16 terminator = st->nSymbols?FSST_CODE_BASE:st->terminator;
       counters.count1Set(terminator,65535); 
 
-      auto addOrInc = [&](unordered_set<QSymbol> &cands, Symbol s, u64 count) {
+      auto addOrInc = [&](CandidateTable &cands, Symbol s, u64 count) {
          if (count < (5*sampleFrac)/128) return; // improves both compression speed (less candidates), but also quality!!
-         QSymbol q;
-         q.symbol = s;
-         q.gain = count * s.length();
-         auto it = cands.find(q);
-         if (it != cands.end()) {
-            q.gain += (*it).gain;
-            cands.erase(*it);
-         }
-         cands.insert(q);
+         cands.addOrInc(s, (u32) (count * s.length()));
       };
 
       // add candidate symbols based on counted frequency
@@ -201,38 +302,50 @@ SymbolTable *buildSymbolTable(Counters& counters, vector<const u8*> line, const
          }
       }
 
-      // insert candidates into priority queue (by gain)
-      auto cmpGn = [](const QSymbol& q1, const QSymbol& q2) { return (q1.gain < q2.gain) || (q1.gain == q2.gain && q1.symbol.val.num > q2.symbol.val.num); };
-      priority_queue<QSymbol,vector<QSymbol>,decltype(cmpGn)> pq(cmpGn);
-      for (auto& q : cands)
-         pq.push(q);
-
-      // Create new symbol map using best candidates
+      // Create new symbol map using best candidates (by gain). We only order the best 256 of them, as that is normally all we need
+      // (but if some cannot be added due to hash table collisions, we continue with the next 256)
+      auto better = [](const QSymbol& q1, const QSymbol& q2) { return (q1.gain > q2.gain) || (q1.gain == q2.gain && q1.symbol.val.num < q2.symbol.val.num); };
+      vector<QSymbol> &order = cands.cands;
       st->clear();
-      while (st->nSymbols < 255 && !pq.empty()) {
-         QSymbol q = pq.top();
-         pq.pop();
-         st->add(q.symbol);
+      for (size_t done = 0; st->nSymbols < 255 && done < order.size(); ) {
+         size_t next = min(order.size(), done + 256);
+         nth_element(order.begin() + done, order.begin() + next - 1, order.end(), better);
+         sort(order.begin() + done, order.begin() + next, better);
+         for (; done < next && st->nSymbols < 255; done++)
+            st->add(order[done].symbol);
       }
    };
 
    u8 bestCounters[512*sizeof(u16)];
+   double prevGain = 0; // gain per sampled byte in the previous round (rounds sample different amounts of data)
+   u32 round = 0;
 #ifdef NONOPT_FSST
    for(size_t frac : {127, 127, 127, 127, 127, 127, 127, 127, 127, 128}) {
       sampleFrac = frac;
 #else
    for(sampleFrac=8; true; sampleFrac += 30) {
 #endif
-      memset(&counters, 0, sizeof(Counters));
       long gain = compressCount(st, counters);
+      round++;
       if (gain >= bestGain) { // a new best solution!
          counters.backup1(bestCounters);
          *bestTable = *st; bestGain = gain;
       } 
       if (sampleFrac >= 128) break; // we do 5 rounds (sampleFrac=8,38,68,98,128)
+
+      // stop early if the table hardly improved (relative to the previous round). The final makeTable() then uses the best
+      // single-symbol counts, like after the last round (which does not count pairs): so we drop the pair counts.
+      double curGain = sampled ? ((double) gain) / sampled : 0;
+      if (gainThreshold > 0 && prevGain > 0 && curGain - prevGain < gainThreshold*prevGain) {
+         counters.clear();
+         break;
+      }
+      prevGain = curGain;
       makeTable(st, counters);
+      counters.clear(); // for the next round
    }
    delete st;
+   if (rounds) *rounds = round;
    counters.restore1(bestCounters);
    makeTable(bestTable, counters);
    bestTable->finalize(zeroTerminated); // renumber codes for more efficient compression
@@ -289,7 +402,8 @@ static inline size_t compressSIMD(SymbolTable &symbolTable, u8* symbolBase, size
             if (++batchPos == 512) break;
          } while(curOff < len[curLine]);
    
-         if ((batchPos == 512) || (outOff > (1<<19)) || (++curLine >= nlines)) { // cannot accumulate more?
+         // cannot accumulate more? (also flush if the next string may not fit the output, as we then stop before it)
+         if ((batchPos == 512) || (outOff > (1<<19)) || (++curLine >= nlines) || (len[curLine]*2 + 7 > budget)) {
             if (batchPos-empty >= 32) { // if we have enough work, fire off fsst_compressAVX512 (32 is due to max 4x8 unrolling)
                // radix-sort jobs on length (longest string first) 
                // -- this provides best load balancing and allows to skip empty jobs at the end
@@ -331,7 +445,7 @@ static inline size_t compressSIMD(SymbolTable &symbolTable, u8* symbolBase, size
                      size_t code = symbolTable.shortCodes[word & 0xFFFF];
                      size_t pos = word & 0xFFFFFF;
                      size_t idx = FSST_HASH(pos)&(symbolTable.hashTabSize-1);
-                     Symbol s = symbolTable.hashTab[idx];
+                     Symbol s = symbolTable.hashProbe(idx, word);
                      out[1] = (u8) word; // speculatively write out escaped byte
                      word &= (0xFFFFFFFFFFFFFFFF >> (u8) s.icl);
                      if ((s.icl < FSST_ICL_FREE) && s.val.num == word) {
@@ -373,17 +487,25 @@ static inline size_t compressSIMD(SymbolTable &symbolTable, u8* symbolBase, size
 }
 
 
-// optimized adaptive *scalar* compression method
-static inline size_t compressBulk(SymbolTable &symbolTable, size_t nlines, const size_t lenIn[], const u8* strIn[], size_t size, u8* out, size_t lenOut[], u8* strOut[], bool noSuffixOpt, bool avoidBranch) {
-   const u8 *cur = NULL, *end =  NULL, *lim = out + size;
-   size_t curLine, suffixLim = symbolTable.suffixLim;
-   u8 byteLim = symbolTable.nSymbols + symbolTable.zeroTerminated - symbolTable.lenHisto[0];
+// optimized adaptive *scalar* compression method. All its options are template arguments, so that every instantiation is a loop
+// without tests on them: the variant, zero-terminated mode (the terminator then is byte 0), and whether all strings are short
+// enough (<= 511 bytes) to be compressed in one chunk, which drops the chunking loop
+template <u8 variant, bool zeroTerminated, bool shortStrings>
+static size_t compressBulk(SymbolTable &symbolTable, size_t nlines, const size_t lenIn[], const u8* strIn[], size_t size, u8* out, size_t lenOut[], u8* strOut[]) {
+   constexpr bool noSuffixOpt = (variant == FSST_VARIANT_NOSUFFIXOPT), avoidBranch = (variant == FSST_VARIANT_AVOIDBRANCH);
+   const u8 *lim = out + size;
+   const size_t suffixLim = symbolTable.suffixLim;
+   const u8 byteLim = symbolTable.nSymbols + zeroTerminated - symbolTable.lenHisto[0];
+   const u8 terminator = zeroTerminated ? 0 : (u8) symbolTable.terminator;
+   size_t curLine;
 
    u8 buf[512+8] = {}; /* +8 sentinel is to avoid 8-byte unaligned-loads going beyond 511 out-of-bounds */
 
-   // three variants are possible. dead code falls away since the bool arguments are constants
-   auto compressVariant = [&](bool noSuffixOpt, bool avoidBranch) {
-      while (cur < end) {
+   // copy a chunk of at most 511 bytes to buf (followed by the terminator), and compress it
+   auto compressChunk = [&](const u8 *str, size_t chunk) {
+      memcpy(buf, str, chunk);
+      buf[chunk] = terminator;
+      for(const u8 *cur = buf, *end = buf + chunk; cur < end; ) {
          u64 word = fsst_unaligned_load(cur);
          size_t code = symbolTable.shortCodes[word & 0xFFFF];
          if (noSuffixOpt && ((u8) code) < suffixLim) {
@@ -392,7 +514,7 @@ static inline size_t compressBulk(SymbolTable &symbolTable, size_t nlines, const
          } else {
             size_t pos = word & 0xFFFFFF;
             size_t idx = FSST_HASH(pos)&(symbolTable.hashTabSize-1);
-            Symbol s = symbolTable.hashTab[idx];
+            Symbol s = symbolTable.hashProbe(idx, word);
             out[1] = (u8) word; // speculatively write out escaped byte
             word &= (0xFFFFFFFFFFFFFFFF >> (u8) s.icl);
             if ((s.icl < FSST_ICL_FREE) && s.val.num == word) {
@@ -417,37 +539,176 @@ static inline size_t compressBulk(SymbolTable &symbolTable, size_t nlines, const
    };
 
    for(curLine=0; curLine<nlines; curLine++) {
-      size_t chunk, curOff = 0;
+      size_t len = lenIn[curLine];
       strOut[curLine] = out;
-      do {
-         cur = strIn[curLine] + curOff; 
-         chunk = lenIn[curLine] - curOff;
-         if (chunk > 511) {
-            chunk = 511; // we need to compress in chunks of 511 in order to be byte-compatible with simd-compressed FSST 
-         }
-         if ((2*chunk+7) > (size_t) (lim-out)) {
+      if (shortStrings) {
+         if ((2*len+7) > (size_t) (lim-out)) {
             return curLine; // out of memory
          }
-         // copy the string to the 511-byte buffer
-         memcpy(buf, cur, chunk);
-         buf[chunk] = (u8) symbolTable.terminator;
-         cur = buf;
-         end = cur + chunk; 
-
-         // based on symboltable stats, choose a variant that is nice to the branch predictor
-         if (noSuffixOpt) {
-            compressVariant(true,false);
-         } else if (avoidBranch) {
-            compressVariant(false,true);
-         } else {
-          compressVariant(false, false);
-         }
-      } while((curOff += chunk) < lenIn[curLine]);
+         compressChunk(strIn[curLine], len);
+      } else {
+         size_t chunk, curOff = 0;
+         do {
+            chunk = min(len - curOff, (size_t) 511); // we need to compress in chunks of 511 in order to be byte-compatible with simd-compressed FSST 
+            if ((2*chunk+7) > (size_t) (lim-out)) {
+               return curLine; // out of memory
+            }
+            compressChunk(strIn[curLine] + curOff, chunk);
+         } while((curOff += chunk) < len);
+      }
       lenOut[curLine] = (size_t) (out - strOut[curLine]);
    } 
    return curLine;
 }
 
+// dispatch to the compressBulk() instantiation for this variant (FSST_VARIANT_*), table and batch
+static size_t compressBulk(SymbolTable &symbolTable, size_t nlines, const size_t lenIn[], const u8* strIn[], size_t size, u8* out, size_t lenOut[], u8* strOut[], u8 variant) {
+   typedef size_t (*BulkFn)(SymbolTable&, size_t, const size_t[], const u8*[], size_t, u8*, size_t[], u8*[]);
+   static const BulkFn bulk[3][2][2] = {
+      { { compressBulk<FSST_VARIANT_PLAIN,false,false>,       compressBulk<FSST_VARIANT_PLAIN,false,true> },
+        { compressBulk<FSST_VARIANT_PLAIN,true,false>,        compressBulk<FSST_VARIANT_PLAIN,true,true> } },
+      { { compressBulk<FSST_VARIANT_AVOIDBRANCH,false,false>, compressBulk<FSST_VARIANT_AVOIDBRANCH,false,true> },
+        { compressBulk<FSST_VARIANT_AVOIDBRANCH,true,false>,  compressBulk<FSST_VARIANT_AVOIDBRANCH,true,true> } },
+      { { compressBulk<FSST_VARIANT_NOSUFFIXOPT,false,false>, compressBulk<FSST_VARIANT_NOSUFFIXOPT,false,true> },
+        { compressBulk<FSST_VARIANT_NOSUFFIXOPT,true,false>,  compressBulk<FSST_VARIANT_NOSUFFIXOPT,true,true> } },
+   };
+   bool shortStrings = all_of(lenIn, lenIn+nlines, [](size_t len) { return len <= 511; });
+   return bulk[variant][symbolTable.zeroTerminated][shortStrings](symbolTable, nlines, lenIn, strIn, size, out, lenOut, strOut);
+}
+
+// order-preserving compression: emit the code of the last range that starts at or before the remaining string
+static inline size_t compressOrdered(SymbolTable &symbolTable, size_t nlines, const size_t lenIn[], const u8* strIn[], size_t size, u8* out, size_t lenOut[], u8* strOut[]) {
+   const u8 *lim = out + size;
+   size_t curLine;
+
+   for(curLine=0; curLine<nlines; curLine++) {
+      const u8 *cur = strIn[curLine], *end = cur + lenIn[curLine];
+      if ((2*lenIn[curLine]+7) > (size_t) (lim-out)) {
+         return curLine; // out of memory
+      }
+      strOut[curLine] = out;
+      while (cur < end) {
+         u32 lo = symbolTable.rangeFirst[*cur], hi = symbolTable.rangeFirst[*cur+1];
+         if (lo == hi) {
+            // no range starts with this byte: escape it (FSST_ESC sorts after all codes, as do these bytes)
+            *out++ = FSST_ESC; *out++ = *cur++;
+            continue;
+         }
+         // binary search among the ranges of this first byte; the first of them always qualifies (it is the byte itself)
+         u32 len = (u32) min((size_t) (end-cur), (size_t) 8);
+         u64 key = fsst_ordered_key(cur, len);
+         while (hi - lo > 1) {
+            u32 mid = (lo + hi) >> 1;
+            if (symbolTable.rangeKey[mid] < key || (symbolTable.rangeKey[mid] == key && symbolTable.rangeLen[mid] <= len))
+               lo = mid;
+            else
+               hi = mid;
+         }
+         *out++ = (u8) lo; cur += symbolTable.symbols[lo].length();
+      }
+      lenOut[curLine] = (size_t) (out - strOut[curLine]);
+   }
+   return curLine;
+}
+
+// the smallest string that is larger than all strings starting with s (empty if there is none)
+static string orderedSuccessor(string s) {
+   while (s.size() && (u8) s.back() == 255) s.pop_back();
+   if (s.size()) s.back()++;
+   return s;
+}
+
+// cut the strings that start with a byte below escapeByte into ranges, each represented by its first string and its symbol.
+// the boundaries are all symbols s and their successors, so the strings that start with s form a series of adjacent ranges.
+// Therefore, the longest symbol that is a prefix of a range boundary is a prefix of all strings in that range.
+static void orderedRanges(const set<string> &symbols, u32 escapeByte, vector<pair<string,string>> &ranges, u32 &symbolBytes) {
+   set<string> bounds;
+   for(auto &s : symbols) {
+      bounds.insert(s);
+      bounds.insert(orderedSuccessor(s));
+   }
+   ranges.clear();
+   symbolBytes = 0;
+   for(auto &b : bounds) {
+      if (b.empty()) continue;
+      if ((u8) b[0] >= escapeByte) break;
+      string symbol = b.substr(0,1);
+      for(size_t len = min(b.size(), (size_t) Symbol::maxLength); len > 1; len--)
+         if (symbols.count(b.substr(0,len))) {
+            symbol = b.substr(0,len);
+            break;
+         }
+      if (ranges.size() && ranges.back().second == symbol) continue; // same symbol as the previous range: merge
+      ranges.emplace_back(b, symbol);
+      symbolBytes += (u32) symbol.size();
+   }
+}
+
+// turn a normal symbol table into an order-preserving one (codes sort like the strings they stand for):
+// - all bytes below the highest byte in the sample get a single-byte symbol. Higher bytes are escaped, which keeps order as FSST_ESC=255.
+// - multi-byte symbols are taken from the normal table in order of their gain on the sample, as long as the ranges fit in the codes
+//   (and their symbols in an exported header). A symbol s costs up to two codes, as it splits the ranges at s and at its successor.
+// - codes are assigned to the ranges in order. The compression tokenization is still greedy (longest matching symbol).
+SymbolTable *buildOrderedTable(SymbolTable *st, vector<const u8*> line, const size_t len[]) {
+   const u32 maxSymbolBytes = FSST_MAXHEADER - 17 - 128; // header, a 4-bits length per code, symbols (see fsst_export)
+   size_t totLen = 0, nlines = line.size();
+   u32 escapeByte = 1, symbolBytes = 0;
+
+   for(size_t i=0; i<nlines; i++) {
+      totLen += len[i];
+      for(size_t j=0; j<len[i]; j++)
+         escapeByte = max(escapeByte, 1+(u32) line[i][j]);
+   }
+   escapeByte = min(escapeByte, 255U);
+
+   // gain of each multi-byte symbol: the bytes it saves when compressing the sample with the normal table
+   vector<u8> buf(2*totLen + 7*nlines + 8);
+   vector<size_t> lenOut(nlines);
+   vector<u8*> strOut(nlines);
+   size_t gain[256] = {};
+   compressBulk(*st, nlines, len, line.data(), buf.size(), buf.data(), lenOut.data(), strOut.data(), FSST_VARIANT_PLAIN);
+   for(size_t i=0; i<nlines; i++)
+      for(u8 *cur = strOut[i], *end = cur + lenOut[i]; cur < end; cur++)
+         if (*cur == FSST_ESC) cur++; else gain[*cur] += st->symbols[*cur].length() - 1;
+
+   vector<u32> cands;
+   for(u32 i=0; i<st->nSymbols; i++)
+      if (st->symbols[i].length() > 1 && gain[i]) cands.push_back(i);
+   stable_sort(cands.begin(), cands.end(), [&](u32 a, u32 b) { return gain[a] > gain[b]; });
+
+   set<string> symbols;
+   vector<pair<string,string>> ranges;
+   for(u32 b=0; b<escapeByte; b++)
+      symbols.insert(string(1, (char) b));
+   for(u32 i : cands) {
+      string s(st->symbols[i].val.str, st->symbols[i].length());
+      if ((u8) s[0] >= escapeByte) continue;
+      symbols.insert(s);
+      orderedRanges(symbols, escapeByte, ranges, symbolBytes);
+      if (ranges.size() > 255 || symbolBytes > maxSymbolBytes) symbols.erase(s); // does not fit
+   }
+   orderedRanges(symbols, escapeByte, ranges, symbolBytes);
+
+   SymbolTable *ot = new SymbolTable();
+   ot->zeroTerminated = st->zeroTerminated;
+   ot->orderPreserving = true;
+   ot->suffixLim = 0;
+   ot->nSymbols = (u16) ranges.size();
+   for(u32 code=0, b=0; code<ot->nSymbols; code++) {
+      auto &r = ranges[code];
+      Symbol s(r.second.data(), (u32) r.second.size());
+      s.set_code_len(code, s.length());
+      ot->symbols[code] = s;
+      ot->lenHisto[s.length()-1]++;
+      ot->rangeKey[code] = fsst_ordered_key((const u8*) r.first.data(), r.first.size());
+      ot->rangeLen[code] = (u8) r.first.size();
+      while (b <= (u8) r.first[0]) ot->rangeFirst[b++] = code;
+      if (code+1 == ot->nSymbols) while (b <= 256) ot->rangeFirst[b++] = ot->nSymbols;
+   }
+   delete st;
+   return ot;
+}
+
 #define FSST_SAMPLELINE ((size_t) 512)
 
 // quickly select a uniformly random set of lines such that we have between [FSST_SAMPLETARGET,FSST_SAMPLEMAXSZ) string bytes
@@ -491,21 +752,93 @@ vector<const u8*> makeSample(u8* sampleBuf, const u8* strIn[], const size_t **le
    return sample;
 }
 
-extern "C" fsst_encoder_t* fsst_create(size_t n, const size_t lenIn[], const u8 *strIn[], int zeroTerminated) {
+// adaptive choosing of scalar compression method based on symbol length histogram (unless autotuned)
+static inline u8 chooseVariant(Encoder *e) {
+   if (e->variant) {
+      return e->variant-1;
+   } else if (100*e->symbolTable->lenHisto[1] > 65*e->symbolTable->nSymbols && 100*e->symbolTable->suffixLim > 95*e->symbolTable->lenHisto[1]) {
+      return FSST_VARIANT_NOSUFFIXOPT;
+   } else if ((e->symbolTable->lenHisto[0] > 24 && e->symbolTable->lenHisto[0] < 92) &&
+              (e->symbolTable->lenHisto[0] < 43 || e->symbolTable->lenHisto[6] + e->symbolTable->lenHisto[7] < 29) &&
+              (e->symbolTable->lenHisto[0] < 72 || e->symbolTable->lenHisto[2] < 72)) {
+      return FSST_VARIANT_AVOIDBRANCH;
+   }
+   return FSST_VARIANT_PLAIN;
+}
+
+// time the compression kernels on the sample (best of 3 runs each). The fastest scalar variant and SIMD unroll are remembered in e
+// only if they beat the heuristic choice by a margin: the sample is small and cache-resident, which flatters the scalar kernels
+static void autotune(Encoder *e, vector<const u8*>& sample, const size_t sampleLen[]) {
+   size_t n = sample.size(), totLen = accumulate(sampleLen, sampleLen+n, (size_t) 0);
+   vector<u8> output(2*totLen+8*n+8); // room for the worst case, so every kernel compresses the whole sample
+   vector<size_t> lenOut(n);
+   vector<u8*> strOut(n);
+   auto timeKernel = [&](bool noSuffixOpt, bool avoidBranch, int simd) {
+      double best = 1e9;
+      for(int run=0; run<3; run++) {
+         auto start = chrono::steady_clock::now();
+         compressImpl(e, n, sampleLen, sample.data(), output.size(), output.data(), lenOut.data(), strOut.data(), noSuffixOpt, avoidBranch, simd);
+         best = min(best, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+      }
+      return best;
+   };
+   const double gain = 1 - FSST_AUTOTUNE_GAIN/100.0, scalarGain = 1 - FSST_AUTOTUNE_SCALARGAIN/100.0;
+   double scalar[3], simd[5];
+   u8 variant = chooseVariant(e), best = variant;
+   for(u8 v : {FSST_VARIANT_PLAIN, FSST_VARIANT_AVOIDBRANCH, FSST_VARIANT_NOSUFFIXOPT}) 
+      scalar[v] = timeKernel(v == FSST_VARIANT_NOSUFFIXOPT, v == FSST_VARIANT_AVOIDBRANCH, 0);
+   for(u8 v : {FSST_VARIANT_PLAIN, FSST_VARIANT_AVOIDBRANCH, FSST_VARIANT_NOSUFFIXOPT}) 
+      if (scalar[v] < scalar[best]) best = v;
+   if (scalar[best] < scalar[variant]*gain) e->variant = 1+(variant = best);
+   if (fsst_hasAVX512()) {
+      u8 unroll = 3; // what fsst_compress() uses by default for large batches
+      for(u8 u=1; u<=4; u++) 
+         simd[u] = timeKernel(false, false, u);
+      for(u8 u=1; u<=4; u++) 
+         if (simd[u] < simd[unroll]) unroll = u;
+      if (simd[unroll] >= simd[3]*gain) unroll = 3;
+      if (scalar[variant] < simd[unroll]*scalarGain) 
+         e->unroll = FSST_UNROLL_NONE;
+      else if (unroll != 3) 
+         e->unroll = unroll;
+   }
+}
+
+extern "C" fsst_encoder_t* fsst_create_ex(size_t n, const size_t lenIn[], const u8 *strIn[], const fsst_options_t *options) {
+   fsst_options_t defaults = {};
+   if (!options) options = &defaults;
    u8* sampleBuf = new u8[FSST_SAMPLEMAXSZ];
    const size_t *sampleLen = lenIn;
    vector<const u8*> sample = makeSample(sampleBuf, strIn, &sampleLen, n?n:1); // careful handling of input to get a right-size and representative sample
    Encoder *encoder = new Encoder();
-   encoder->symbolTable = shared_ptr<SymbolTable>(buildSymbolTable(encoder->counters, sample, sampleLen, zeroTerminated));
+   SymbolTable *symbolTable = buildSymbolTable(encoder->counters, sample, sampleLen, options->zeroTerminated, options->gainThreshold, &encoder->rounds);
+   if (options->orderPreserving)
+      symbolTable = buildOrderedTable(symbolTable, sample, sampleLen);
+   encoder->symbolTable = shared_ptr<SymbolTable>(symbolTable);
+   if (options->autotune && !options->orderPreserving) 
+      autotune(encoder, sample, sampleLen);
    if (sampleLen != lenIn) delete[] sampleLen; 
    delete[] sampleBuf; 
    return (fsst_encoder_t*) encoder;
 }
 
+extern "C" fsst_encoder_t* fsst_create(size_t n, const size_t lenIn[], const u8 *strIn[], int zeroTerminated) {
+   fsst_options_t options = {};
+   options.zeroTerminated = zeroTerminated;
+   return fsst_create_ex(n, lenIn, strIn, &options);
+}
+
+extern "C" u32 fsst_training_rounds(fsst_encoder_t *encoder) {
+   return ((Encoder*) encoder)->rounds;
+}
+
 /* create another encoder instance, necessary to do multi-threaded encoding using the same symbol table */
 extern "C" fsst_encoder_t* fsst_duplicate(fsst_encoder_t *encoder) {
    Encoder *e = new Encoder();
    e->symbolTable = ((Encoder*)encoder)->symbolTable; // it is a shared_ptr
+   e->rounds = ((Encoder*)encoder)->rounds;
+   e->variant = ((Encoder*)encoder)->variant;
+   e->unroll = ((Encoder*)encoder)->unroll;
    return (fsst_encoder_t*) e;
 }
 
@@ -526,7 +859,7 @@ extern "C" u32 fsst_export(fsst_encoder_t *encoder, u8 *buf) {
    // The version field is now there just for future-proofness, but not used yet
    
    // version allows keeping track of fsst versions, track endianness, and encoder reconstruction
-   u64 version = (FSST_VERSION << 32) |  // version is 24 bits, most significant byte is 0 
+   u64 version = ((e->symbolTable->orderPreserving?FSST_VERSION_ORDERED:FSST_VERSION) << 32) |  // version is 24 bits, most significant byte is 0 
                  (((u64) e->symbolTable->suffixLim) << 24) | 
                  (((u64) e->symbolTable->terminator) << 16) | 
                  (((u64) e->symbolTable->nSymbols) << 8) | 
@@ -539,6 +872,17 @@ extern "C" u32 fsst_export(fsst_encoder_t *encoder, u8 *buf) {
       buf[9+i] = (u8) e->symbolTable->lenHisto[i];
    u32 pos = 17;
 
+   if (e->symbolTable->orderPreserving) {
+      // codes are not grouped by length, so emit the length of each code (4 bits each), followed by all symbols
+      for(u32 i = 0; i < e->symbolTable->nSymbols; i += 2)
+         buf[pos++] = (e->symbolTable->symbols[i].length()-1) | 
+                      ((i+1 < e->symbolTable->nSymbols)?((e->symbolTable->symbols[i+1].length()-1) << 4):0);
+      for(u32 i = 0; i < e->symbolTable->nSymbols; i++)
+         for(u32 j = 0; j < e->symbolTable->symbols[i].length(); j++)
+            buf[pos++] = e->symbolTable->symbols[i].val.str[j];
+      return pos;
+   }
+
    // emit only the used bytes of the symbols 
    for(u32 i = e->symbolTable->zeroTerminated; i < e->symbolTable->nSymbols; i++)
       for(u32 j = 0; j < e->symbolTable->symbols[i].length(); j++)
@@ -556,7 +900,7 @@ extern "C" u32 fsst_import(fsst_decoder_t *decoder, u8 const *buf) {
 
    // version field (first 8 bytes) is now there just for future-proofness, unused still (skipped)
    memcpy(&version, buf, 8);
-   if ((version>>32) != FSST_VERSION) return 0;
+   if ((version>>32) != FSST_VERSION && (version>>32) != FSST_VERSION_ORDERED) return 0;
    decoder->zeroTerminated = buf[8]&1;
    memcpy(lenHisto, buf+9, 8);
 
@@ -564,6 +908,22 @@ extern "C" u32 fsst_import(fsst_decoder_t *decoder, u8 const *buf) {
    decoder->len[0] = 1;
    decoder->symbol[0] = 0;
 
+   if ((version>>32) == FSST_VERSION_ORDERED) { // order-preserving symbol table: 4-bits lengths of all codes, then the symbols
+      u32 nSymbols = (version >> 8) & 255;
+      pos += (nSymbols+1)/2;
+      for(code=0; code<nSymbols; code++) {
+         decoder->len[code] = ((buf[17+code/2] >> ((code&1)*4)) & 15) + 1;
+         decoder->symbol[code] = 0;
+         for(u32 j=0; j<decoder->len[code]; j++) 
+            ((u8*) &decoder->symbol[code])[j] = buf[pos++];
+      }
+      while(code<255) {
+          decoder->symbol[code] = FSST_CORRUPT;    
+          decoder->len[code++] = 8;
+      }
+      return pos;
+   }
+
    // we use lenHisto[0] as 1-byte symbol run length (at the end)
    code = decoder->zeroTerminated;
    if (decoder->zeroTerminated) lenHisto[0]--; // if zeroTerminated, then symbol "" aka 1-byte code=0, is not stored at the end
@@ -589,39 +949,88 @@ extern "C" u32 fsst_import(fsst_decoder_t *decoder, u8 const *buf) {
 
 // runtime check for simd
 inline size_t _compressImpl(Encoder *e, size_t nlines, const size_t lenIn[], const u8 *strIn[], size_t size, u8 *output, size_t *lenOut, u8 *strOut[], bool noSuffixOpt, bool avoidBranch, int simd) {
+   if (e->symbolTable->orderPreserving) // ranges instead of longest-match lookup tables: own (scalar) kernel
+      return compressOrdered(*e->symbolTable, nlines, lenIn, strIn, size, output, lenOut, strOut);
 #ifndef NONOPT_FSST
    if (simd && fsst_hasAVX512())
       return compressSIMD(*e->symbolTable, e->simdbuf, nlines, lenIn, strIn, size, output, lenOut, strOut, simd);
 #endif
    (void) simd;
-   return compressBulk(*e->symbolTable, nlines, lenIn, strIn, size, output, lenOut, strOut, noSuffixOpt, avoidBranch);
+   u8 variant = noSuffixOpt ? FSST_VARIANT_NOSUFFIXOPT : avoidBranch ? FSST_VARIANT_AVOIDBRANCH : FSST_VARIANT_PLAIN;
+   return compressBulk(*e->symbolTable, nlines, lenIn, strIn, size, output, lenOut, strOut, variant);
 }
 size_t compressImpl(Encoder *e, size_t nlines, const size_t lenIn[], const u8 *strIn[], size_t size, u8 *output, size_t *lenOut, u8 *strOut[], bool noSuffixOpt, bool avoidBranch, int simd) {
    return _compressImpl(e, nlines, lenIn, strIn, size, output, lenOut, strOut, noSuffixOpt, avoidBranch, simd);
 }
 
-// adaptive choosing of scalar compression method based on symbol length histogram 
 inline size_t _compressAuto(Encoder *e, size_t nlines, const size_t lenIn[], const u8 *strIn[], size_t size, u8 *output, size_t *lenOut, u8 *strOut[], int simd) {
-   bool avoidBranch = false, noSuffixOpt = false;
-   if (100*e->symbolTable->lenHisto[1] > 65*e->symbolTable->nSymbols && 100*e->symbolTable->suffixLim > 95*e->symbolTable->lenHisto[1]) {
-      noSuffixOpt = true;
-   } else if ((e->symbolTable->lenHisto[0] > 24 && e->symbolTable->lenHisto[0] < 92) &&
-              (e->symbolTable->lenHisto[0] < 43 || e->symbolTable->lenHisto[6] + e->symbolTable->lenHisto[7] < 29) &&
-              (e->symbolTable->lenHisto[0] < 72 || e->symbolTable->lenHisto[2] < 72)) {
-      avoidBranch = true;
-   }
+   u8 variant = chooseVariant(e);
+   bool avoidBranch = (variant == FSST_VARIANT_AVOIDBRANCH), noSuffixOpt = (variant == FSST_VARIANT_NOSUFFIXOPT);
    return _compressImpl(e, nlines, lenIn, strIn, size, output, lenOut, strOut, noSuffixOpt, avoidBranch, simd);
 }
 size_t compressAuto(Encoder *e, size_t nlines, const size_t lenIn[], const u8 *strIn[], size_t size, u8 *output, size_t *lenOut, u8 *strOut[], int simd) {
    return _compressAuto(e, nlines, lenIn, strIn, size, output, lenOut, strOut, simd);
 }
 
+// the SIMD unroll degree to compress a batch with (0: scalar)
+static inline int chooseSimd(Encoder *e, size_t nlines, size_t totLen) {
+   // to be faster than scalar, simd needs 64 lines or more of length >=12; or fewer lines, but big ones (totLen > 32KB)
+   int simd = totLen > nlines*12 && (nlines > 64 || totLen > (size_t) 1<<15); 
+   if (e->unroll == FSST_UNROLL_NONE) return 0; // autotuned: scalar was faster
+   return (e->unroll?e->unroll:3)*simd;
+}
+
 // the main compression function (everything automatic)
 extern "C" size_t fsst_compress(fsst_encoder_t *encoder, size_t nlines, const size_t lenIn[], const u8 *strIn[], size_t size, u8 *output, size_t *lenOut, u8 *strOut[]) {
-   // to be faster than scalar, simd needs 64 lines or more of length >=12; or fewer lines, but big ones (totLen > 32KB)
    size_t totLen = accumulate(lenIn, lenIn+nlines, 0);
-   int simd = totLen > nlines*12 && (nlines > 64 || totLen > (size_t) 1<<15); 
-   return _compressAuto((Encoder*) encoder, nlines, lenIn, strIn, size, output, lenOut, strOut, 3*simd);
+   return _compressAuto((Encoder*) encoder, nlines, lenIn, strIn, size, output, lenOut, strOut, chooseSimd((Encoder*) encoder, nlines, totLen));
+}
+
+extern "C" const char* fsst_kernel_name(fsst_encoder_t *encoder) {
+   static const char *scalar[] = { "scalar", "scalar-avoidBranch", "scalar-noSuffixOpt" };
+   static const char *simd[] = { "avx512-unroll1", "avx512-unroll2", "avx512-unroll3", "avx512-unroll4" };
+   Encoder *e = (Encoder*) encoder;
+   if (e->symbolTable->orderPreserving) 
+      return "ordered";
+   if (e->unroll != FSST_UNROLL_NONE && fsst_hasAVX512()) 
+      return simd[(e->unroll?e->unroll:3)-1];
+   return scalar[chooseVariant(e)];
+}
+
+// compression of strings in a data buffer plus offsets: we compress batches of them through the pointer-based compressors, which
+// write the compressed strings one after the other, so the output offsets follow from the compressed lengths
+#define FSST_OFFSETBATCH 1024
+
+template <typename T>
+static inline size_t compressOffsets(Encoder *e, size_t nlines, const T offsetsIn[], const u8 *dataIn, size_t size, u8 *output, T offsetsOut[]) {
+   size_t lenIn[FSST_OFFSETBATCH], lenOut[FSST_OFFSETBATCH], done = 0;
+   const u8 *strIn[FSST_OFFSETBATCH];
+   u8 *strOut[FSST_OFFSETBATCH];
+
+   size = min(size, (size_t) (T) ~(T) 0); // output offsets must fit T
+   offsetsOut[0] = 0;
+   while (done < nlines) {
+      size_t batch = min(nlines-done, (size_t) FSST_OFFSETBATCH), totLen = 0, pos = offsetsOut[done];
+      for(size_t i=0; i<batch; i++) {
+         lenIn[i] = offsetsIn[done+i+1] - offsetsIn[done+i];
+         strIn[i] = dataIn + offsetsIn[done+i];
+         totLen += lenIn[i];
+      }
+      size_t compressed = _compressAuto(e, batch, lenIn, strIn, size-pos, output+pos, lenOut, strOut, chooseSimd(e, batch, totLen));
+      for(size_t i=0; i<compressed; i++) 
+         offsetsOut[done+i+1] = offsetsOut[done+i] + (T) lenOut[i];
+      done += compressed;
+      if (compressed < batch) break; // output buffer full
+   }
+   return done;
+}
+
+extern "C" size_t fsst_compress_offsets32(fsst_encoder_t *encoder, size_t nlines, const u32 offsetsIn[], const u8 *dataIn, size_t size, u8 *output, u32 offsetsOut[]) {
+   return compressOffsets((Encoder*) encoder, nlines, offsetsIn, dataIn, size, output, offsetsOut);
+}
+
+extern "C" size_t fsst_compress_offsets64(fsst_encoder_t *encoder, size_t nlines, const unsigned long long offsetsIn[], const u8 *dataIn, size_t size, u8 *output, unsigned long long offsetsOut[]) {
+   return compressOffsets((Encoder*) encoder, nlines, offsetsIn, dataIn, size, output, offsetsOut);
 }
 
 /* deallocate encoder */
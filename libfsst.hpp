@@ -17,15 +17,15 @@
 // You can contact the authors via the FSST source repository : https://github.com/cwida/fsst 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
 #include <cstring>
 #include <fstream>
 #include <iostream>
 #include <numeric>
 #include <memory>
-#include <queue>
+#include <set>
 #include <string>
-#include <unordered_set>
 #include <vector>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -45,6 +45,8 @@ typedef uint64_t u64;
 #define FSST_ENDIAN_MARKER ((u64) 1)
 #define FSST_VERSION_20190218 20190218
 #define FSST_VERSION ((u64) FSST_VERSION_20190218)
+#define FSST_VERSION_20261018 20261018
+#define FSST_VERSION_ORDERED ((u64) FSST_VERSION_20261018) // order-preserving symbol tables, which older fsst_import() must reject
 
 // "symbols" are character sequences (up to 8 bytes)
 // A symbol is compressed into a "code" of, in principle, one byte. But, we added an exception mechanism:
@@ -63,6 +65,17 @@ inline uint64_t fsst_unaligned_load(u8 const* V) {
     return Ret;
 }
 
+// the first (up to 8) bytes of a string as a big-endian number, zero-padded: integer order is string order on these bytes
+inline uint64_t fsst_ordered_key(u8 const* V, size_t len) {
+    uint64_t Ret = 0;
+    memcpy(&Ret, V, len < 8 ? len : 8);
+#ifdef _MSC_VER
+    return _byteswap_uint64(Ret);
+#else
+    return __builtin_bswap64(Ret);
+#endif
+}
+
 struct Symbol {
    static const unsigned maxLength = 8;
 
@@ -103,11 +116,10 @@ struct Symbol {
    size_t hash() const { size_t v = 0xFFFFFF & val.num; return FSST_HASH(v); } // hash on the next 3 bytes
 };
 
-// Symbol that can be put in a queue, ordered on gain
+// candidate Symbol with its gain, symbol table construction picks the candidates with the highest gain
 struct QSymbol{
    Symbol symbol;
-   mutable u32 gain; // mutable because gain value should be ignored in find() on unordered_set of QSymbols
-   bool operator==(const QSymbol& other) const { return symbol.val.num == other.symbol.val.num && symbol.length() == other.symbol.length(); }
+   u32 gain;
 };
 
 // we construct FSST symbol tables using a random sample of about 16KB (1<<14) 
@@ -139,6 +151,15 @@ struct QSymbol{
 // in the hash table, the icl field contains (low-to-high) ignoredBits:16,code:12,length:4
 #define FSST_ICL_FREE ((15<<28)|(((u32)FSST_CODE_MASK)<<16)) // high bits of icl (len=8,code=FSST_CODE_MASK) indicates free bucket
 
+// with FSST_HASH_WAYS > 1, the hash table consists of buckets of that many slots (FSST_HASH_WAYS=4: one cache line), that hold the
+// symbols of the hash (i.e. bucket) ordered by decreasing length, free slots last. A symbol is then only rejected if its bucket is
+// full, and there can be several symbols with the same 3-byte prefix (e.g. "http://" and "https://"). A probe tests the slots in 
+// order, so the first match is the longest. With FSST_HASH_WAYS=1 (the default), there is a single slot per hash (a rejected symbol 
+// is dropped from the symbol table).
+#ifndef FSST_HASH_WAYS
+#define FSST_HASH_WAYS 1
+#endif
+
 // ignoredBits is (8-length)*8, which is the amount of high bits to zero in the input word before comparing with the hashtable key
 //             ..it could of course be computed from len during lookup, but storing it precomputed in some loose bits is faster
 //
@@ -146,8 +167,12 @@ struct QSymbol{
 
 struct SymbolTable {
    static const u32 hashTabSize = 1<<FSST_HASH_LOG2SIZE; // smallest size that incurs no precision loss
+   static const u32 hashTabWays = FSST_HASH_WAYS; // slots per bucket (the low bits of a hashTab[] index are the slot)
 
    // lookup table using the next two bytes (65536 codes), or just the next single byte
+   // it is 128KB, but compression only touches the entries of the byte pairs that occur in the data, which stay cached. Compact
+   // layouts of a few KB (a first-byte table plus a bitmap+rank of second bytes, or plus a row per first byte of a 2-byte symbol)
+   // made compressBulk() slower on every paper/dbtext table (20-35%), because of their dependent loads.
    u16 shortCodes[65536]; // contains code for 2-byte symbol, otherwise code for pseudo byte (escaped byte)
 
    // lookup table (only used during symbolTable construction, not during normal text compression)
@@ -165,7 +190,15 @@ struct SymbolTable {
    bool zeroTerminated;   // whether we are expecting zero-terminated strings (we then also produce zero-terminated compressed strings)
    u16 lenHisto[FSST_CODE_BITS]; // lenHisto[x] is the amount of symbols of byte-length (x+1) in this SymbolTable
 
-   SymbolTable() : nSymbols(0), suffixLim(FSST_CODE_MAX), terminator(0), zeroTerminated(false) {
+   // order-preserving tables (see buildOrderedTable) do not use shortCodes[]/hashTab[]: code x stands for the range of strings that
+   // starts at the (big-endian, zero-padded) rangeKey[x] of length rangeLen[x], and the codes [rangeFirst[b],rangeFirst[b+1]> are the 
+   // ranges whose strings start with byte b. Bytes without ranges are escaped.
+   bool orderPreserving;
+   u64 rangeKey[256];
+   u8 rangeLen[256];
+   u16 rangeFirst[257];
+
+   SymbolTable() : nSymbols(0), suffixLim(FSST_CODE_MAX), terminator(0), zeroTerminated(false), orderPreserving(false) {
       // stuff done once at startup
       for (u32 i=0; i<256; i++) {
          symbols[i] = Symbol(i,i|(1<<FSST_LEN_BITS)); // pseudo symbols
@@ -203,21 +236,40 @@ struct SymbolTable {
               u16 val = symbols[i].first2();
               shortCodes[val] = (1<<FSST_LEN_BITS) | (val&255);
           } else {
-              u32 idx = symbols[i].hash() & (hashTabSize-1);
-              hashTab[idx].val.num = 0;
-              hashTab[idx].icl = FSST_ICL_FREE; //marks empty in hashtab
+              u32 idx = symbols[i].hash() & (hashTabSize-hashTabWays);
+              for(u32 w=0; w<hashTabWays; w++) { // clears the whole bucket
+                 hashTab[idx+w].val.num = 0;
+                 hashTab[idx+w].icl = FSST_ICL_FREE; //marks empty in hashtab
+              }
           }           
       } 
       nSymbols = 0; // no need to clean symbols[] as no symbols are used
    }
    bool hashInsert(Symbol s) {
-      u32 idx = s.hash() & (hashTabSize-1);
-      bool taken = (hashTab[idx].icl < FSST_ICL_FREE);
-      if (taken) return false; // collision in hash table
-      hashTab[idx].icl = s.icl;
-      hashTab[idx].val.num = s.val.num & (0xFFFFFFFFFFFFFFFF >> (u8) s.icl);
+      u32 idx = s.hash() & (hashTabSize-hashTabWays);
+      bool taken = (hashTab[idx+hashTabWays-1].icl < FSST_ICL_FREE);
+      if (taken) return false; // collision in hash table (the bucket is full)
+      u32 w = 0; // keep the bucket ordered by decreasing length, so the first match in a probe is the longest
+      while (hashTab[idx+w].icl < FSST_ICL_FREE && hashTab[idx+w].length() >= s.length()) w++;
+      for(u32 v=hashTabWays-1; v>w; v--) 
+         hashTab[idx+v] = hashTab[idx+v-1];
+      hashTab[idx+w].icl = s.icl;
+      hashTab[idx+w].val.num = s.val.num & (0xFFFFFFFFFFFFFFFF >> (u8) s.icl);
       return true;
    }
+   // probe the bucket of hashTab[idx] for the longest symbol that is a prefix of word (the next 8 input bytes). 
+   // The caller still needs to test whether the returned slot matches (it is the last slot of the bucket if none does).
+   Symbol hashProbe(size_t idx, u64 word) const {
+#if FSST_HASH_WAYS > 1
+      idx &= hashTabSize-hashTabWays;
+      for(u32 w=0; w<hashTabWays-1; w++, idx++)
+         if ((hashTab[idx].icl < FSST_ICL_FREE) & (hashTab[idx].val.num == (word & (0xFFFFFFFFFFFFFFFF >> (u8) hashTab[idx].icl))))
+            break;
+#else
+      (void) word;
+#endif
+      return hashTab[idx];
+   }
    bool add(Symbol s) {
       assert(FSST_CODE_BASE + nSymbols < FSST_CODE_MAX);
       u32 len = s.length();
@@ -235,10 +287,11 @@ struct SymbolTable {
    }
    /// Find longest expansion, return code (= position in symbol table)
    u16 findLongestSymbol(Symbol s) const {
-      size_t idx = s.hash() & (hashTabSize-1);
-      if (hashTab[idx].icl <= s.icl && hashTab[idx].val.num == (s.val.num & (0xFFFFFFFFFFFFFFFF >> ((u8) hashTab[idx].icl)))) {
-         return (hashTab[idx].icl>>16) & FSST_CODE_MASK; // matched a long symbol 
-      }
+      size_t idx = s.hash() & (hashTabSize-hashTabWays);
+      for(u32 w=0; w<hashTabWays; w++, idx++) 
+         if (hashTab[idx].icl <= s.icl && hashTab[idx].val.num == (s.val.num & (0xFFFFFFFFFFFFFFFF >> ((u8) hashTab[idx].icl)))) {
+            return (hashTab[idx].icl>>16) & FSST_CODE_MASK; // matched a long symbol 
+         }
       if (s.length() >= 2) {
          u16 code =  shortCodes[s.first2()] & FSST_CODE_MASK;
          if (code >= FSST_CODE_BASE) return code; 
@@ -352,6 +405,9 @@ struct Counters {
    void restore1(u8 *buf) {
       memcpy(count1, buf, FSST_CODE_MAX*sizeof(u16));
    }
+   void clear() {
+      memset(this, 0, sizeof(Counters));
+   }
 };
 #else
 // we keep two counters count1[pos] and count2[pos1][pos2] of resp 16 and 12-bits. Both are split into two columns for performance reasons
@@ -413,6 +469,18 @@ struct Counters {
       memcpy(count1High, buf, FSST_CODE_MAX);
       memcpy(count1Low, buf+FSST_CODE_MAX, FSST_CODE_MAX);
    }
+   void clear() { // reset all counters to zero, touching only the count2 rows that can be nonzero (not all 385KB)
+      // compressCount() always does count1Inc(pos1) before count2Inc(pos1,pos2), so a count2 row can only be nonzero
+      // if its count1 is (which we see from count1High, as it is incremented early)
+      for(u32 pos1=0; pos1<FSST_CODE_MAX; pos1++) {
+         if (count1High[pos1]) {
+            memset(count2High[pos1], 0, FSST_CODE_MAX/2);
+            memset(count2Low[pos1], 0, FSST_CODE_MAX);
+         }
+      }
+      memset(count1High, 0, FSST_CODE_MAX);
+      memset(count1Low, 0, FSST_CODE_MAX);
+   }
 }; 
 #endif
 
@@ -423,11 +491,22 @@ struct Counters {
 struct Encoder {
    shared_ptr<SymbolTable> symbolTable; // symbols, plus metadata and data structures for quick compression (shortCode,hashTab, etc)
    union {
-      Counters counters;     // for counting symbol occurences during map construction
+      Counters counters;     // for counting symbol occurences during map construction (zero in a new Encoder())
       u8 simdbuf[FSST_BUFSZ]; // for compression: SIMD string staging area 768KB = 256KB in + 512KB out (worst case for 256KB in) 
    };
+   u32 rounds; // training rounds used by buildSymbolTable()
+   u8 variant; // compressBulk() variant picked by autotune(): 0 = none (compressAuto() decides), else 1+FSST_VARIANT_*
+   u8 unroll;  // SIMD unroll degree picked by autotune(): 0 = none (fsst_compress() uses 3), FSST_UNROLL_NONE = scalar is faster
 };
 
+// the compressBulk() variants (see compressAuto)
+#define FSST_VARIANT_PLAIN 0
+#define FSST_VARIANT_AVOIDBRANCH 1
+#define FSST_VARIANT_NOSUFFIXOPT 2
+#define FSST_UNROLL_NONE 255
+#define FSST_AUTOTUNE_GAIN 10 // %: autotune() keeps the heuristic kernel unless another one is this much faster on the sample
+#define FSST_AUTOTUNE_SCALARGAIN 30 // %: .. and keeps SIMD for large batches unless scalar is this much faster (uuid: 13-25%, yet slower on the column)
+
 // job control integer representable in one 64bits SIMD lane: cur/end=input, out=output, pos=which string (2^9=512 per call)
 struct SIMDjob {
    u64 out:19,pos:9,end:18,cur:18; // cur/end is input offsets (2^18=256KB), out is output offset (2^19=512KB)  
@@ -436,6 +515,12 @@ struct SIMDjob {
 extern bool 
 fsst_hasAVX512(); // runtime check for avx512 capability
 
+extern bool 
+fsst_hasAVX512VBMI(); // runtime check for avx512 byte permutes (VBMI) and byte arithmetic (BW)
+
+extern bool 
+fsst_hasAVX512DQ(); // runtime check for avx512 64-bits multiplies (DQ)
+
 extern size_t 
 fsst_compressAVX512(
    SymbolTable &symbolTable, 
@@ -446,6 +531,14 @@ fsst_compressAVX512(
    size_t n,         // IN: size of arrays input and output (should be max 512)
    size_t unroll);   // IN: degree of SIMD unrolling
 
+extern void
+fsst_tokenizeAVX512(
+   SymbolTable &symbolTable, // IN: symbol table under construction (not finalized: 9-bits codes)
+   const u8* sample,  // IN: the sample, with 8 zero bytes after each line
+   u16* codes,        // OUT: the code of each token, at the sample offset where the token starts
+   const u64* jobs,   // IN: the lines to tokenize (size n), as sample offsets [end:32][cur:32]
+   size_t n);         // IN: number of lines
+
 // C++ fsst-compress function with some more control of how the compression happens (algorithm flavor, simd unroll degree)
-size_t compressImpl(Encoder *encoder, size_t n, size_t lenIn[], u8 *strIn[], size_t size, u8 * output, size_t *lenOut, u8 *strOut[], bool noSuffixOpt, bool avoidBranch, int simd);
-size_t compressAuto(Encoder *encoder, size_t n, size_t lenIn[], u8 *strIn[], size_t size, u8 * output, size_t *lenOut, u8 *strOut[], int simd);
+size_t compressImpl(Encoder *encoder, size_t n, const size_t lenIn[], const u8 *strIn[], size_t size, u8 * output, size_t *lenOut, u8 *strOut[], bool noSuffixOpt, bool avoidBranch, int simd);
+size_t compressAuto(Encoder *encoder, size_t n, const size_t lenIn[], const u8 *strIn[], size_t size, u8 * output, size_t *lenOut, u8 *strOut[], int simd);
@@ -73,7 +73,7 @@ class NoCompressionRunner : public CompressionRunner {
 
 /// FSST compression
 class FSSTCompressionRunner : public CompressionRunner {
-   private:
+   protected:
    /// The decode
    fsst_decoder_t decoder;
    /// The compressed data
@@ -91,7 +91,8 @@ class FSSTCompressionRunner : public CompressionRunner {
       offsets.clear();
 
       vector<unsigned long> rowLens, compressedRowLens;
-      vector<unsigned char*> rowPtrs, compressedRowPtrs;
+      vector<const unsigned char*> rowPtrs;
+      vector<unsigned char*> compressedRowPtrs;
       rowLens.reserve(data.size());
       compressedRowLens.resize(data.size());
       rowPtrs.reserve(data.size());
@@ -100,7 +101,7 @@ class FSSTCompressionRunner : public CompressionRunner {
       for (auto& d : data) {
          totalLen += d.size();
          rowLens.push_back(d.size());
-         rowPtrs.push_back(reinterpret_cast<unsigned char*>(const_cast<char*>(d.data())));
+         rowPtrs.push_back(reinterpret_cast<const unsigned char*>(d.data()));
       }
 
       auto firstTime = std::chrono::steady_clock::now();
@@ -111,10 +112,10 @@ class FSSTCompressionRunner : public CompressionRunner {
       auto createTime = std::chrono::steady_clock::now();
       vector<unsigned char> compressionBuffer, fullBuffer;
       fullBuffer.resize(totalLen);
-      unsigned char *fullBuf = fullBuffer.data();
+      const unsigned char *fullBuf = fullBuffer.data();
       unsigned stringEnd = 0;
       for (auto& d : data) {
-         memcpy(fullBuf + stringEnd, d.data(), d.length());
+         memcpy(fullBuffer.data() + stringEnd, d.data(), d.length());
          stringEnd += d.length();
       }
       compressionBuffer.resize(16 + 2 * totalLen);
@@ -171,6 +172,52 @@ class FSSTCompressionRunner : public CompressionRunner {
    }
 };
 
+/// FSST compression, decompressing the selected rows with fsst_decompress_selected32 (software prefetching)
+class FSSTSelectedCompressionRunner : public FSSTCompressionRunner {
+   private:
+   /// The row start offsets (plus the end of the last row)
+   vector<unsigned> rowOffsets;
+   /// A small staging area for the decompressed rows, and their offsets in it
+   vector<unsigned char> staging;
+   vector<unsigned> stagingOffsets;
+
+   public:
+   FSSTSelectedCompressionRunner() {}
+   FSSTSelectedCompressionRunner(unsigned /*blockSizeIgnored*/) {}
+
+   /// Store the compressed corpus. Returns the compressed size
+   uint64_t compressCorpus(const vector<string>& data, unsigned long& bareSize, double& bulkTime, double& compressionTime, bool verbose) override {
+      uint64_t result = FSSTCompressionRunner::compressCorpus(data, bareSize, bulkTime, compressionTime, verbose);
+      rowOffsets.assign(1, 0);
+      rowOffsets.insert(rowOffsets.end(), offsets.begin(), offsets.end());
+      return result;
+   }
+   /// Decompress some selected rows, separated by newlines. The line number are in ascending order. The target buffer is guaranteed to be large enough
+   virtual uint64_t decompressRows(vector<char>& target, const vector<unsigned>& lines) {
+      constexpr unsigned batch = 256;
+      char* writer = target.data();
+      stagingOffsets.resize(batch + 1);
+      for (size_t done = 0; done < lines.size();) {
+         // the staging area stays cache resident: a batch that does not fit is copied out in parts, and only if not even one
+         // row fits, the staging area grows
+         size_t n = min(lines.size() - done, static_cast<size_t>(batch));
+         size_t decoded = fsst_decompress_selected32(&decoder, lines.data() + done, n, rowOffsets.data(), compressedData.data(), staging.size(), staging.data(), stagingOffsets.data());
+         if (!decoded) {
+            staging.resize(2 * staging.size() + 4096);
+            continue;
+         }
+         for (size_t index = 0; index != decoded; ++index) {
+            unsigned len = stagingOffsets[index + 1] - stagingOffsets[index];
+            memcpy(writer, staging.data() + stagingOffsets[index], len);
+            writer[len] = '\n';
+            writer += len + 1;
+         }
+         done += decoded;
+      }
+      return writer - target.data();
+   }
+};
+
 /// LZ4 compression with a given block size
 class LZ4CompressionRunner : public CompressionRunner {
    private:
@@ -481,6 +528,9 @@ int main(int argc, const char* argv[]) {
    } else if (method == "fsst") {
       FSSTCompressionRunner runner;
       return !doTest(runner, files, true).first;
+   } else if (method == "fsstselected") {
+      FSSTSelectedCompressionRunner runner;
+      return !doTest(runner, files, true).first;
    } else if (method == "lz4") {
       LZ4CompressionRunner runner(blockSize);
       return !doTest(runner, files, true).first;
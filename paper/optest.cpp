@@ -0,0 +1,1116 @@
+// this software is distributed under the MIT License (http://www.opensource.org/licenses/MIT):
+//
+// Copyright 2018-2020, CWI, TU Munich, FSU Jena
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files
+// (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify,
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// - The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+// IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+#include "fsst.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace std;
+
+// Test program for operations that database systems perform on FSST-compressed columns (without decompressing them).
+//
+// substring: LIKE '%needle%' for needles of 1-12 bytes, on the compressed strings (fsst_matcher_substring) vs. memmem after
+//          decompressing batches of 1024 strings (the results are checked against the original strings)
+// prefix: LIKE 'prefix%' for prefixes of 1-20 bytes, on the compressed strings (fsst_prefix_match_batch) vs. memcmp after
+//          decompressing batches of 1024 strings (the results are checked against the original strings)
+// regex:  ten regular expressions on the compressed strings (fsst_matcher_regex), checked against (and timed vs.) std::regex on
+//          the original strings, and a user DFA (fsst_matcher_dfa) that accepts an even number of digits
+// hash:   hash all strings of a column, compressed vs. decompressed, and group-by the column in a compact hash table
+//         that keeps the (compressed vs. decompressed) keys inline (fsst::compact_hash_table)
+// ordered: compression ratio of an order-preserving symbol table vs. a normal one, and check that compressed strings sort like
+//          the originals (and decompress to them)
+// keys:    extract 8- and 16-byte normalized sort keys (fsst_extract_prefix_keys) vs. after decompressing batches of 1024 strings,
+//          check that the keys order the strings like memcmp (unless they are equal and flagged as ties), and the % of ties
+// lookup:  random point lookups in batches on a large column (the file repeated to 1GB), decompressing the strings one after
+//          the other vs. interleaved (fsst_decompress_interleaved): latency per batch (p50, p99) and throughput
+// pairs:   decompression speed of fsst_decompress vs. a pair decoder (fsst_pair_decompress) with 256, 1024 and 1792 pairs
+// wide:    decompression speed of fsst_decompress vs. fsst_decompress_wide on the file cut into 4KB and 64KB documents
+// stream:  decompression speed of the file as one string with fsst_decompress (into a buffer for all of it) vs. streaming it
+//          through a 64KB and a 4KB buffer (fsst_decode_stream_next)
+// range:   substr() of 100 bytes at a random offset of 64KB documents: decompressing the document vs. fsst_decompress_range,
+//          without and with checkpoints every 1KB
+// fused:   hashing all strings of a column, after decompressing batches of 1024 strings vs. fused with decompression
+//          (fsst::for_each_decoded)
+// write:   writing a column to a file: decompressed as a whole and written at once vs. through a 64KB buffer (fsst::write_decoded),
+//          and counting the lines of the file, compressed as one string, with fsst::symbol_iterator vs. after decompression
+// parallel: decompressing a large column (the file repeated to 512MB) with fsst_decompress_offsets64 vs.
+//          fsst_decompress_parallel64 with 1, 2, 4 and all hardware threads
+
+/// A column of strings, compressed with FSST
+struct Column {
+   /// The rows
+   vector<string> rows;
+   /// The row lengths and pointers
+   vector<size_t> lens;
+   vector<const unsigned char*> ptrs;
+   /// The compressed rows
+   vector<unsigned char> compressed;
+   vector<size_t> compressedLens;
+   vector<unsigned char*> compressedPtrs;
+   /// The decoder
+   fsst_decoder_t decoder;
+   /// The total uncompressed size
+   size_t totalLen = 0;
+
+   /// Read a file as a column of lines (or of documents of documentLen bytes, if set), and compress it
+   bool load(const string& file, const fsst_options_t* options = nullptr, size_t documentLen = 0) {
+      ifstream in(file);
+      if (!in.is_open()) {
+         cerr << "unable to open " << file << endl;
+         return false;
+      }
+      if (documentLen) {
+         string document(documentLen, 0);
+         while (in.read(&document[0], documentLen) || in.gcount())
+            rows.push_back(document.substr(0, in.gcount()));
+      } else {
+         string line;
+         while (getline(in, line))
+            rows.push_back(move(line));
+      }
+      if (!compress(options)) {
+         cerr << "unable to compress " << file << endl;
+         return false;
+      }
+      return true;
+   }
+
+   /// Compress the rows
+   bool compress(const fsst_options_t* options = nullptr) {
+      for (auto& r : rows) {
+         totalLen += r.length();
+         lens.push_back(r.length());
+         ptrs.push_back(reinterpret_cast<const unsigned char*>(r.data()));
+      }
+      auto encoder = fsst_create_ex(rows.size(), lens.data(), ptrs.data(), options);
+      compressed.resize(16 + 2 * totalLen + 7 * rows.size());
+      compressedLens.resize(rows.size());
+      compressedPtrs.resize(rows.size());
+      bool ok = fsst_compress(encoder, rows.size(), lens.data(), ptrs.data(), compressed.size(), compressed.data(), compressedLens.data(), compressedPtrs.data()) == rows.size();
+      decoder = fsst_decoder(encoder);
+      fsst_destroy(encoder);
+      return ok;
+   }
+};
+
+/// Search a column for substrings (LIKE '%needle%'), with a matcher on the compressed strings vs. memmem after decompression
+static bool substringTest(const string& file) {
+   Column column;
+   if (!column.load(file)) return false;
+   constexpr unsigned repeat = 10, batch = 1024;
+   size_t n = column.rows.size();
+   vector<unsigned char> buffer(column.totalLen + 8 * batch + 4096);
+   vector<size_t> batchLens(batch), selection(n), expected(n);
+   vector<const unsigned char*> batchPtrs(batch);
+
+   // needles of 1, 3, 6 and 12 bytes cut out of random rows, and one that (most likely) does not occur
+   mt19937 rng(42);
+   vector<string> needles;
+   for (size_t len : {1, 3, 6, 12}) {
+      for (unsigned tries = 0; tries != 1000; ++tries) {
+         const string& row = column.rows[rng() % n];
+         if (row.length() >= len) {
+            needles.push_back(row.substr(rng() % (row.length() - len + 1), len));
+            break;
+         }
+      }
+   }
+   needles.push_back("\x01\x02\x03");
+
+   auto decompressBatch = [&](size_t first, size_t count) {
+      unsigned char* writer = buffer.data();
+      for (size_t i = 0; i < count; i++) {
+         batchPtrs[i] = writer;
+         writer += batchLens[i] = fsst_decompress(&column.decoder, column.compressedLens[first + i], column.compressedPtrs[first + i], buffer.data() + buffer.size() - writer, writer);
+      }
+   };
+   auto time = [&](auto&& fn) {
+      auto startTime = std::chrono::steady_clock::now();
+      for (unsigned index = 0; index != repeat; ++index)
+         fn();
+      auto stopTime = std::chrono::steady_clock::now();
+      return std::chrono::duration<double>(stopTime - startTime).count() * 1e9 / (repeat * n); // ns per row
+   };
+
+   double compressed = 0, decompressed = 0;
+   size_t matches = 0;
+   for (auto& needle : needles) {
+      auto matcher = fsst_matcher_substring(&column.decoder, needle.length(), reinterpret_cast<const unsigned char*>(needle.data()));
+      size_t count = 0, expectedCount = 0;
+      for (size_t i = 0; i < n; i++)
+         if (column.rows[i].find(needle) != string::npos) expected[expectedCount++] = i;
+      compressed += time([&]() {
+         count = fsst_matcher_match_batch(matcher, n, column.compressedLens.data(), const_cast<const unsigned char**>(column.compressedPtrs.data()), selection.data());
+      });
+      fsst_matcher_destroy(matcher);
+      if (count != expectedCount || !equal(selection.begin(), selection.begin() + count, expected.begin())) {
+         cerr << "substring mismatch for needle '" << needle << "'" << endl;
+         return false;
+      }
+      size_t countDecompressed = 0;
+      decompressed += time([&]() {
+         countDecompressed = 0;
+         for (size_t first = 0; first < n; first += batch) {
+            size_t count = min<size_t>(batch, n - first);
+            decompressBatch(first, count);
+            for (size_t i = 0; i < count; i++) {
+               selection[countDecompressed] = first + i;
+               countDecompressed += memmem(batchPtrs[i], batchLens[i], needle.data(), needle.length()) != nullptr;
+            }
+         }
+      });
+      if (countDecompressed != expectedCount) {
+         cerr << "substring mismatch after decompression for needle '" << needle << "'" << endl;
+         return false;
+      }
+      matches += count;
+   }
+   cout << "\t" << compressed / needles.size() << "\t" << decompressed / needles.size() << "\t" << matches;
+   return true;
+}
+
+/// Filter a column on prefixes (LIKE 'prefix%'), on the compressed strings vs. memcmp after decompression
+static bool prefixTest(const string& file) {
+   Column column;
+   if (!column.load(file)) return false;
+   constexpr unsigned repeat = 10, batch = 1024;
+   size_t n = column.rows.size();
+   vector<unsigned char> buffer(column.totalLen + 8 * batch + 4096);
+   vector<size_t> batchLens(batch), selection(n), expected(n);
+   vector<const unsigned char*> batchPtrs(batch);
+
+   // the first 1, 3, 8, 12 and 20 bytes of random rows, and a prefix that (most likely) does not occur
+   mt19937 rng(42);
+   vector<string> prefixes;
+   for (size_t len : {1, 3, 8, 12, 20}) {
+      for (unsigned tries = 0; tries != 1000; ++tries) {
+         const string& row = column.rows[rng() % n];
+         if (row.length() >= len) {
+            prefixes.push_back(row.substr(0, len));
+            break;
+         }
+      }
+   }
+   prefixes.push_back("\x01\x02\x03");
+
+   auto decompressBatch = [&](size_t first, size_t count) {
+      unsigned char* writer = buffer.data();
+      for (size_t i = 0; i < count; i++) {
+         batchPtrs[i] = writer;
+         writer += batchLens[i] = fsst_decompress(&column.decoder, column.compressedLens[first + i], column.compressedPtrs[first + i], buffer.data() + buffer.size() - writer, writer);
+      }
+   };
+   auto time = [&](auto&& fn) {
+      auto startTime = std::chrono::steady_clock::now();
+      for (unsigned index = 0; index != repeat; ++index)
+         fn();
+      auto stopTime = std::chrono::steady_clock::now();
+      return std::chrono::duration<double>(stopTime - startTime).count() * 1e9 / (repeat * n); // ns per row
+   };
+
+   double compressed = 0, decompressed = 0;
+   size_t matches = 0;
+   for (auto& prefix : prefixes) {
+      const unsigned char* prefixPtr = reinterpret_cast<const unsigned char*>(prefix.data());
+      size_t count = 0, expectedCount = 0;
+      for (size_t i = 0; i < n; i++)
+         if (!column.rows[i].compare(0, prefix.length(), prefix)) expected[expectedCount++] = i;
+      compressed += time([&]() {
+         count = fsst_prefix_match_batch(&column.decoder, n, column.compressedLens.data(), const_cast<const unsigned char**>(column.compressedPtrs.data()), prefix.length(), prefixPtr, selection.data());
+      });
+      if (count != expectedCount || !equal(selection.begin(), selection.begin() + count, expected.begin())) {
+         cerr << "prefix mismatch for prefix '" << prefix << "'" << endl;
+         return false;
+      }
+      for (size_t i = 0; i < n; i++) {
+         if (fsst_prefix_match(&column.decoder, column.compressedLens[i], column.compressedPtrs[i], prefix.length(), prefixPtr) != !column.rows[i].compare(0, prefix.length(), prefix)) {
+            cerr << "prefix mismatch for prefix '" << prefix << "' in row " << i << endl;
+            return false;
+         }
+      }
+      size_t countDecompressed = 0;
+      decompressed += time([&]() {
+         countDecompressed = 0;
+         for (size_t first = 0; first < n; first += batch) {
+            size_t count = min<size_t>(batch, n - first);
+            decompressBatch(first, count);
+            for (size_t i = 0; i < count; i++) {
+               selection[countDecompressed] = first + i;
+               countDecompressed += batchLens[i] >= prefix.length() && !memcmp(batchPtrs[i], prefixPtr, prefix.length());
+            }
+         }
+      });
+      if (countDecompressed != expectedCount) {
+         cerr << "prefix mismatch after decompression for prefix '" << prefix << "'" << endl;
+         return false;
+      }
+      matches += count;
+   }
+   cout << "\t" << compressed / prefixes.size() << "\t" << decompressed / prefixes.size() << "\t" << matches;
+   return true;
+}
+
+/// Evaluate regular expressions on a column, with a matcher on the compressed strings vs. std::regex on the original strings
+static bool regexTest(const string& file) {
+   Column column;
+   if (!column.load(file)) return false;
+   constexpr unsigned repeat = 10;
+   size_t n = column.rows.size();
+   vector<size_t> selection(n), expected(n);
+
+   // the patterns, and the same for std::regex (where '.' does not match line terminators, but it does in ours)
+   const vector<pair<string, string>> patterns = {
+      {"[0-9]+", "[0-9]+"}, {"^[A-Z]", "^[A-Z]"}, {"e$", "e$"}, {"(the|and)", "(the|and)"}, {"\\d\\d\\d", "\\d\\d\\d"},
+      {"^a.*e$", "^a[\\s\\S]*e$"}, {"[^a-z0-9 ]", "[^a-z0-9 ]"}, {"\\s\\w+\\s", "\\s\\w+\\s"}, {"o+k?n", "o+k?n"}, {"c.m", "c[\\s\\S]m"}};
+
+   auto time = [&](unsigned times, auto&& fn) {
+      auto startTime = std::chrono::steady_clock::now();
+      for (unsigned index = 0; index != times; ++index)
+         fn();
+      auto stopTime = std::chrono::steady_clock::now();
+      return std::chrono::duration<double>(stopTime - startTime).count() * 1e9 / (times * n); // ns per row
+   };
+
+   double compressed = 0, reference = 0;
+   size_t matches = 0;
+   for (auto& pattern : patterns) {
+      auto matcher = fsst_matcher_regex(&column.decoder, pattern.first.c_str());
+      if (!matcher) {
+         cerr << "unable to compile " << pattern.first << endl;
+         return false;
+      }
+      std::regex regex(pattern.second);
+      size_t count = 0, expectedCount = 0;
+      reference += time(1, [&]() {
+         expectedCount = 0;
+         for (size_t i = 0; i < n; i++)
+            if (regex_search(column.rows[i], regex)) expected[expectedCount++] = i;
+      });
+      compressed += time(repeat, [&]() {
+         count = fsst_matcher_match_batch(matcher, n, column.compressedLens.data(), const_cast<const unsigned char**>(column.compressedPtrs.data()), selection.data());
+      });
+      fsst_matcher_destroy(matcher);
+      if (count != expectedCount || !equal(selection.begin(), selection.begin() + count, expected.begin())) {
+         cerr << "regex mismatch for " << pattern.first << endl;
+         return false;
+      }
+      matches += count;
+   }
+
+   // a user DFA: an even number of digits
+   vector<unsigned> next(2 * 256);
+   for (unsigned state = 0; state != 2; ++state)
+      for (unsigned c = 0; c != 256; ++c)
+         next[state * 256 + c] = (c >= '0' && c <= '9') ? 1 - state : state;
+   const unsigned char accepting[2] = {1, 0};
+   auto matcher = fsst_matcher_dfa(&column.decoder, 2, next.data(), accepting);
+   for (size_t i = 0; i < n; i++) {
+      size_t digits = count_if(column.rows[i].begin(), column.rows[i].end(), [](char c) { return c >= '0' && c <= '9'; });
+      if (fsst_matcher_match(matcher, column.compressedLens[i], column.compressedPtrs[i]) != !(digits & 1)) {
+         cerr << "dfa mismatch in row " << i << endl;
+         return false;
+      }
+   }
+   fsst_matcher_destroy(matcher);
+   cout << "\t" << compressed / patterns.size() << "\t" << reference / patterns.size() << "\t" << matches;
+   return true;
+}
+
+/// Hash a column, and group on it, with compressed and with decompressed strings
+static bool hashTest(const string& file) {
+   Column column;
+   if (!column.load(file)) return false;
+   constexpr unsigned repeat = 10, batch = 1024;
+   size_t n = column.rows.size();
+   vector<unsigned long long> hashes(n);
+   vector<unsigned char> buffer(column.totalLen + 8 * batch + 4096);
+   vector<size_t> batchLens(batch);
+   vector<const unsigned char*> batchPtrs(batch);
+
+   // decompress a batch of rows, and hash the decompressed strings
+   auto decompressBatch = [&](size_t first, size_t count) {
+      unsigned char* writer = buffer.data();
+      for (size_t i = 0; i < count; i++) {
+         batchPtrs[i] = writer;
+         writer += batchLens[i] = fsst_decompress(&column.decoder, column.compressedLens[first + i], column.compressedPtrs[first + i], buffer.data() + buffer.size() - writer, writer);
+      }
+   };
+   auto time = [&](auto&& fn) {
+      auto startTime = std::chrono::steady_clock::now();
+      for (unsigned index = 0; index != repeat; ++index)
+         fn();
+      auto stopTime = std::chrono::steady_clock::now();
+      return std::chrono::duration<double>(stopTime - startTime).count() * 1e9 / (repeat * n); // ns per row
+   };
+
+   double hashCompressed = time([&]() {
+      fsst_hash_batch(n, column.compressedLens.data(), const_cast<const unsigned char**>(column.compressedPtrs.data()), hashes.data());
+   });
+   double hashDecompressed = time([&]() {
+      for (size_t first = 0; first < n; first += batch) {
+         size_t count = min<size_t>(batch, n - first);
+         decompressBatch(first, count);
+         fsst_hash_batch(count, batchLens.data(), batchPtrs.data(), hashes.data() + first);
+      }
+   });
+   size_t groupsCompressed = 0, groupsDecompressed = 0, memoryCompressed = 0, memoryDecompressed = 0;
+   double groupCompressed = time([&]() {
+      fsst::compact_hash_table table(n);
+      fsst_hash_batch(n, column.compressedLens.data(), const_cast<const unsigned char**>(column.compressedPtrs.data()), hashes.data());
+      for (size_t i = 0; i < n; i++)
+         table.add(hashes[i], column.compressedLens[i], column.compressedPtrs[i]);
+      groupsCompressed = table.size();
+      memoryCompressed = table.memory();
+   });
+   double groupDecompressed = time([&]() {
+      fsst::compact_hash_table table(n);
+      for (size_t first = 0; first < n; first += batch) {
+         size_t count = min<size_t>(batch, n - first);
+         decompressBatch(first, count);
+         fsst_hash_batch(count, batchLens.data(), batchPtrs.data(), hashes.data() + first);
+         for (size_t i = 0; i < count; i++)
+            table.add(hashes[first + i], batchLens[i], batchPtrs[i]);
+      }
+      groupsDecompressed = table.size();
+      memoryDecompressed = table.memory();
+   });
+   if (groupsCompressed != groupsDecompressed) {
+      cerr << "group count mismatch " << groupsCompressed << " " << groupsDecompressed << endl;
+      return false;
+   }
+   cout << "\t" << hashCompressed << "\t" << hashDecompressed << "\t" << groupCompressed << "\t" << groupDecompressed << "\t" << groupsCompressed << "\t" << memoryCompressed << "\t" << memoryDecompressed;
+   return true;
+}
+
+/// Compare two strings like memcmp, shorter strings first on a tie
+static int compareStrings(size_t len1, const unsigned char* str1, size_t len2, const unsigned char* str2) {
+   int cmp = memcmp(str1, str2, min(len1, len2));
+   if (cmp) return cmp < 0 ? -1 : 1;
+   return (len1 < len2) ? -1 : (len1 > len2);
+}
+
+/// Compress a column with an order-preserving symbol table, and compare with a normal one
+static bool orderedTest(const string& file) {
+   Column normal, ordered;
+   fsst_options_t options = {};
+   options.orderPreserving = 1;
+   if (!normal.load(file) || !ordered.load(file, &options))
+      return false;
+
+   size_t normalLen = 0, orderedLen = 0;
+   for (auto len : normal.compressedLens) normalLen += len;
+   for (auto len : ordered.compressedLens) orderedLen += len;
+
+   // sort the rows, then check that each neighbour pair compares the same compressed
+   vector<size_t> order(ordered.rows.size());
+   for (size_t index = 0; index != order.size(); ++index) order[index] = index;
+   sort(order.begin(), order.end(), [&](size_t a, size_t b) { return ordered.rows[a] < ordered.rows[b]; });
+   for (size_t index = 1; index < order.size(); ++index) {
+      size_t a = order[index - 1], b = order[index];
+      int expected = compareStrings(ordered.lens[a], ordered.ptrs[a], ordered.lens[b], ordered.ptrs[b]);
+      int actual = compareStrings(ordered.compressedLens[a], ordered.compressedPtrs[a], ordered.compressedLens[b], ordered.compressedPtrs[b]);
+      if (expected != actual) {
+         cerr << "order mismatch for rows " << a << " and " << b << endl;
+         return false;
+      }
+   }
+   // an ordered symbol table must have its own header version, so that readers without the format reject it
+   unsigned char header[2][FSST_MAXHEADER];
+   unsigned long long version[2];
+   for (int which = 0; which != 2; ++which) {
+      auto encoder = fsst_create_ex(ordered.rows.size(), ordered.lens.data(), ordered.ptrs.data(), which ? &options : nullptr);
+      fsst_export(encoder, header[which]);
+      fsst_destroy(encoder);
+      memcpy(&version[which], header[which], 8);
+   }
+   fsst_decoder_t imported;
+   if ((version[0] >> 32) == (version[1] >> 32) || !fsst_import(&imported, header[1])) {
+      cerr << "ordered symbol table header has version " << (version[1] >> 32) << endl;
+      return false;
+   }
+   vector<unsigned char> buffer(ordered.totalLen + 8);
+   for (size_t index = 0; index != ordered.rows.size(); ++index) {
+      size_t len = fsst_decompress(&ordered.decoder, ordered.compressedLens[index], ordered.compressedPtrs[index], buffer.size(), buffer.data());
+      if (len != ordered.lens[index] || memcmp(buffer.data(), ordered.ptrs[index], len)) {
+         cerr << "decompression mismatch for row " << index << endl;
+         return false;
+      }
+   }
+   cout << "\t" << (static_cast<double>(normal.totalLen) / normalLen) << "\t" << (static_cast<double>(ordered.totalLen) / orderedLen)
+        << "\t" << (100.0 * orderedLen / normalLen - 100.0);
+   return true;
+}
+
+/// Extract 8- and 16-byte sort keys from a column, from the compressed strings vs. after decompression, and check their order
+static bool keysTest(const string& file) {
+   Column column, edges;
+   if (!column.load(file)) return false;
+   constexpr unsigned repeat = 10, batch = 1024;
+   size_t n = column.rows.size();
+   vector<unsigned char> buffer(column.totalLen + 8 * batch + 4096), ties(n);
+   vector<size_t> batchLens(batch);
+   vector<const unsigned char*> batchPtrs(batch);
+   vector<unsigned long long> keys(2 * n), keysDecompressed(2 * n);
+
+   // edge cases for the tie flags: prefixes of the rows of (about) the key lengths, with and without trailing zero bytes
+   for (size_t index = 0; index < min<size_t>(n, 1000); ++index) {
+      const string& row = column.rows[index];
+      for (size_t len : {size_t(0), size_t(7), size_t(8), size_t(15), size_t(16), row.length()}) {
+         edges.rows.push_back(row.substr(0, len));
+         edges.rows.push_back(row.substr(0, len) + string(1, '\0'));
+         edges.rows.push_back(row.substr(0, len) + string(2, '\0'));
+      }
+   }
+   if (!edges.compress()) {
+      cerr << "unable to compress the edge cases" << endl;
+      return false;
+   }
+
+   // the first keyLen bytes of a string, zero-padded, as big-endian words
+   auto makeKey = [](size_t len, const unsigned char* str, size_t keyLen, unsigned long long* key) {
+      for (size_t word = 0; word < keyLen / 8; word++) {
+         key[word] = 0;
+         for (size_t i = 8 * word; i < 8 * word + 8; i++)
+            key[word] = (key[word] << 8) | (i < len ? str[i] : 0);
+      }
+   };
+   // check that the keys are the zero-padded prefixes, and that they order the strings like memcmp (sorted neighbours and random
+   // pairs), unless they are equal and one of them is a tie
+   auto check = [&](Column& c, size_t keyLen) {
+      size_t m = c.rows.size(), words = keyLen / 8;
+      vector<unsigned long long> k(2 * m);
+      vector<unsigned char> t(m);
+      fsst_extract_prefix_keys(&c.decoder, m, c.compressedLens.data(), const_cast<const unsigned char**>(c.compressedPtrs.data()), keyLen, k.data(), t.data());
+      for (size_t i = 0; i < m; i++) {
+         unsigned long long expected[2];
+         makeKey(c.lens[i], c.ptrs[i], keyLen, expected);
+         if (!equal(expected, expected + words, k.begin() + i * words)) {
+            cerr << "key mismatch in row " << i << endl;
+            return false;
+         }
+      }
+      vector<size_t> order(m);
+      for (size_t index = 0; index != m; ++index) order[index] = index;
+      sort(order.begin(), order.end(), [&](size_t a, size_t b) { return compareStrings(c.lens[a], c.ptrs[a], c.lens[b], c.ptrs[b]) < 0; });
+      mt19937_64 rng(42);
+      vector<pair<size_t, size_t>> pairs;
+      for (size_t index = 1; index < m; ++index) pairs.emplace_back(order[index - 1], order[index]);
+      for (size_t index = 0; index < m; ++index) pairs.emplace_back(rng() % m, rng() % m);
+      for (auto& p : pairs) {
+         size_t a = p.first, b = p.second;
+         int expected = compareStrings(c.lens[a], c.ptrs[a], c.lens[b], c.ptrs[b]), actual = 0;
+         for (size_t word = 0; word < words && !actual; word++)
+            actual = (k[a * words + word] < k[b * words + word]) ? -1 : (k[a * words + word] > k[b * words + word]);
+         if (actual ? (actual != expected) : (expected && !t[a] && !t[b])) {
+            cerr << "order mismatch for rows " << a << " and " << b << " with " << keyLen << "-byte keys" << endl;
+            return false;
+         }
+      }
+      return true;
+   };
+   auto decompressBatch = [&](size_t first, size_t count) {
+      unsigned char* writer = buffer.data();
+      for (size_t i = 0; i < count; i++) {
+         batchPtrs[i] = writer;
+         writer += batchLens[i] = fsst_decompress(&column.decoder, column.compressedLens[first + i], column.compressedPtrs[first + i], buffer.data() + buffer.size() - writer, writer);
+      }
+   };
+   auto time = [&](auto&& fn) {
+      auto startTime = std::chrono::steady_clock::now();
+      for (unsigned index = 0; index != repeat; ++index)
+         fn();
+      auto stopTime = std::chrono::steady_clock::now();
+      return std::chrono::duration<double>(stopTime - startTime).count() * 1e9 / (repeat * n); // ns per row
+   };
+
+   for (size_t keyLen : {8, 16}) {
+      if (!check(column, keyLen) || !check(edges, keyLen)) return false;
+      size_t tieCount = 0;
+      double compressed = time([&]() {
+         tieCount = fsst_extract_prefix_keys(&column.decoder, n, column.compressedLens.data(), const_cast<const unsigned char**>(column.compressedPtrs.data()), keyLen, keys.data(), ties.data());
+      });
+      double decompressed = time([&]() {
+         for (size_t first = 0; first < n; first += batch) {
+            size_t count = min<size_t>(batch, n - first);
+            decompressBatch(first, count);
+            for (size_t i = 0; i < count; i++)
+               makeKey(batchLens[i], batchPtrs[i], keyLen, keysDecompressed.data() + (first + i) * keyLen / 8);
+         }
+      });
+      if (!equal(keys.begin(), keys.begin() + n * keyLen / 8, keysDecompressed.begin())) {
+         cerr << "key mismatch after decompression" << endl;
+         return false;
+      }
+      cout << "\t" << compressed << "\t" << decompressed << "\t" << (100.0 * tieCount / n);
+   }
+   return true;
+}
+
+/// Random point lookups in batches on a large column, one after the other vs. interleaved
+static bool lookupTest(const string& file) {
+   Column column;
+   if (!column.load(file)) return false;
+   constexpr size_t targetSize = size_t(1) << 30;
+   constexpr unsigned batch = 16, batches = 200000;
+
+   // repeat the compressed rows until the column is larger than the caches
+   vector<unsigned char> data;
+   vector<size_t> offsets(1, 0);
+   size_t maxLen = 0;
+   data.reserve(targetSize + column.compressed.size());
+   while (data.size() < targetSize) {
+      for (size_t index = 0; index != column.rows.size(); ++index) {
+         data.insert(data.end(), column.compressedPtrs[index], column.compressedPtrs[index] + column.compressedLens[index]);
+         offsets.push_back(data.size());
+         maxLen = max(maxLen, column.lens[index]);
+      }
+   }
+   mt19937_64 g(123);
+   vector<size_t> keys(batch * batches);
+   for (auto& key : keys)
+      key = g() % (offsets.size() - 1);
+
+   vector<unsigned char> buffer(batch * (maxLen + 8)), check(maxLen + 8);
+   vector<size_t> lenIn(batch), size(batch, maxLen + 8), lenOut(batch);
+   vector<const unsigned char*> strIn(batch);
+   vector<unsigned char*> output(batch);
+   for (unsigned i = 0; i != batch; ++i)
+      output[i] = buffer.data() + i * (maxLen + 8);
+
+   auto run = [&](bool interleaved, vector<double>& latencies) {
+      latencies.resize(batches);
+      auto startTime = std::chrono::steady_clock::now();
+      for (unsigned b = 0; b != batches; ++b) {
+         auto batchStart = std::chrono::steady_clock::now();
+         for (unsigned i = 0; i != batch; ++i) {
+            size_t key = keys[b * batch + i];
+            lenIn[i] = offsets[key + 1] - offsets[key];
+            strIn[i] = data.data() + offsets[key];
+         }
+         if (interleaved) {
+            fsst_decompress_interleaved(&column.decoder, batch, lenIn.data(), strIn.data(), size.data(), output.data(), lenOut.data());
+         } else {
+            for (unsigned i = 0; i != batch; ++i)
+               lenOut[i] = fsst_decompress(&column.decoder, lenIn[i], strIn[i], size[i], output[i]);
+         }
+         latencies[b] = std::chrono::duration<double>(std::chrono::steady_clock::now() - batchStart).count() * 1e9;
+      }
+      return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+   };
+
+   // check the interleaved results
+   vector<double> latencies;
+   for (unsigned b = 0; b != 100; ++b) {
+      for (unsigned i = 0; i != batch; ++i) {
+         size_t key = keys[b * batch + i];
+         lenIn[i] = offsets[key + 1] - offsets[key];
+         strIn[i] = data.data() + offsets[key];
+      }
+      fsst_decompress_interleaved(&column.decoder, batch, lenIn.data(), strIn.data(), size.data(), output.data(), lenOut.data());
+      for (unsigned i = 0; i != batch; ++i) {
+         size_t len = fsst_decompress(&column.decoder, lenIn[i], strIn[i], check.size(), check.data());
+         if (len != lenOut[i] || memcmp(check.data(), output[i], len)) {
+            cerr << "interleaved decompression mismatch" << endl;
+            return false;
+         }
+      }
+   }
+   for (bool interleaved : {false, true}) {
+      double seconds = run(interleaved, latencies);
+      sort(latencies.begin(), latencies.end());
+      cout << "\t" << latencies[batches / 2] << "\t" << latencies[batches * 99 / 100] << "\t" << (batch * batches / seconds / 1e6);
+   }
+   return true;
+}
+
+/// Decompress a column with fsst_decompress and with pair decoders
+static bool pairsTest(const string& file) {
+   Column column;
+   if (!column.load(file)) return false;
+   constexpr unsigned repeat = 20;
+   size_t n = column.rows.size();
+   vector<unsigned char> buffer(column.totalLen + 4096), check(column.totalLen + 4096);
+
+   auto time = [&](auto&& decompress) {
+      auto startTime = std::chrono::steady_clock::now();
+      for (unsigned index = 0; index != repeat; ++index) {
+         unsigned char* writer = buffer.data();
+         for (size_t i = 0; i < n; i++)
+            writer += decompress(column.compressedLens[i], column.compressedPtrs[i], buffer.data() + buffer.size() - writer, writer);
+      }
+      auto stopTime = std::chrono::steady_clock::now();
+      return (column.totalLen * repeat) / std::chrono::duration<double>(stopTime - startTime).count() / (1 << 20); // MB/s
+   };
+
+   cout << "\t" << time([&](size_t lenIn, const unsigned char* strIn, size_t size, unsigned char* output) { return fsst_decompress(&column.decoder, lenIn, strIn, size, output); });
+   check = buffer;
+   for (size_t maxPairs : {256, 1024, 1792}) {
+      auto pairDecoder = fsst_pair_decoder_create(&column.decoder, n, column.compressedLens.data(), const_cast<const unsigned char**>(column.compressedPtrs.data()), maxPairs);
+      cout << "\t" << time([&](size_t lenIn, const unsigned char* strIn, size_t size, unsigned char* output) { return fsst_pair_decompress(pairDecoder, lenIn, strIn, size, output); });
+      fsst_pair_decoder_destroy(pairDecoder);
+      if (memcmp(buffer.data(), check.data(), column.totalLen)) {
+         cerr << "pair decompression mismatch" << endl;
+         return false;
+      }
+   }
+   return true;
+}
+
+/// Decompress a column of documents with fsst_decompress and fsst_decompress_wide
+static bool wideTest(const string& file) {
+   for (size_t documentLen : {4096, 65536}) {
+      Column column;
+      if (!column.load(file, nullptr, documentLen)) return false;
+      unsigned repeat = 1 + (100 << 20) / column.totalLen; // ~100MB per measurement
+      size_t n = column.rows.size();
+      vector<unsigned char> buffer(column.totalLen + 4096), check;
+
+      auto time = [&](auto&& decompress) {
+         auto startTime = std::chrono::steady_clock::now();
+         for (unsigned index = 0; index != repeat; ++index) {
+            unsigned char* writer = buffer.data();
+            for (size_t i = 0; i < n; i++)
+               writer += decompress(column.compressedLens[i], column.compressedPtrs[i], buffer.data() + buffer.size() - writer, writer);
+         }
+         auto stopTime = std::chrono::steady_clock::now();
+         return (column.totalLen * repeat) / std::chrono::duration<double>(stopTime - startTime).count() / (1 << 20); // MB/s
+      };
+
+      cout << "\t" << time([&](size_t lenIn, const unsigned char* strIn, size_t size, unsigned char* output) { return fsst_decompress(&column.decoder, lenIn, strIn, size, output); });
+      check = buffer;
+      cout << "\t" << time([&](size_t lenIn, const unsigned char* strIn, size_t size, unsigned char* output) { return fsst_decompress_wide(&column.decoder, lenIn, strIn, size, output); });
+      if (memcmp(buffer.data(), check.data(), column.totalLen)) {
+         cerr << "wide decompression mismatch" << endl;
+         return false;
+      }
+   }
+   return true;
+}
+
+/// Decompress a file compressed as one string at once, and streaming through small buffers
+static bool streamTest(const string& file) {
+   Column column;
+   if (!column.load(file, nullptr, 64 << 20)) return false;
+   if (column.rows.size() != 1) {
+      cerr << file << " is too large" << endl;
+      return false;
+   }
+   unsigned repeat = 1 + (200 << 20) / column.totalLen; // ~200MB per measurement
+   vector<unsigned char> buffer(column.totalLen + 4096);
+
+   auto startTime = std::chrono::steady_clock::now();
+   for (unsigned index = 0; index != repeat; ++index)
+      fsst_decompress(&column.decoder, column.compressedLens[0], column.compressedPtrs[0], buffer.size(), buffer.data());
+   auto stopTime = std::chrono::steady_clock::now();
+   cout << "\t" << (column.totalLen * repeat) / std::chrono::duration<double>(stopTime - startTime).count() / (1 << 20);
+
+   for (size_t cap : {65536, 4096}) {
+      vector<unsigned char> chunk(cap);
+      bool same = true;
+      startTime = std::chrono::steady_clock::now();
+      for (unsigned index = 0; index != repeat; ++index) {
+         fsst_decode_stream_t stream;
+         fsst_decode_stream_init(&stream, &column.decoder, column.compressedLens[0], column.compressedPtrs[0]);
+         size_t pos = 0;
+         for (size_t len; (len = fsst_decode_stream_next(&stream, cap, chunk.data())) != 0; pos += len)
+            same &= (pos + len <= column.totalLen) && !memcmp(chunk.data(), column.rows[0].data() + pos, len);
+         same &= (pos == column.totalLen);
+      }
+      stopTime = std::chrono::steady_clock::now();
+      if (!same) {
+         cerr << "stream decompression mismatch" << endl;
+         return false;
+      }
+      cout << "\t" << (column.totalLen * repeat) / std::chrono::duration<double>(stopTime - startTime).count() / (1 << 20);
+   }
+   return true;
+}
+
+/// Extract substrings from documents, with fsst_decompress and fsst_decompress_range
+static bool rangeTest(const string& file) {
+   Column column;
+   if (!column.load(file, nullptr, 65536)) return false;
+   constexpr unsigned lookups = 10000, substrLen = 100;
+   size_t n = column.rows.size();
+   vector<unsigned> rows(lookups);
+   vector<size_t> froms(lookups);
+   mt19937 rng(42);
+   for (unsigned i = 0; i != lookups; ++i) {
+      rows[i] = rng() % n;
+      froms[i] = rng() % column.lens[rows[i]];
+   }
+   vector<vector<fsst_checkpoint_t>> checkpoints(n);
+   for (size_t i = 0; i < n; i++) {
+      checkpoints[i].resize(64);
+      checkpoints[i].resize(fsst_range_checkpoints(&column.decoder, column.compressedLens[i], column.compressedPtrs[i], 1024, 64, checkpoints[i].data()));
+   }
+   vector<unsigned char> buffer(65536 + 4096), result(substrLen);
+
+   bool same = true;
+   auto time = [&](auto&& substr) {
+      auto startTime = std::chrono::steady_clock::now();
+      for (unsigned i = 0; i != lookups; ++i) {
+         size_t len = substr(rows[i], froms[i]);
+         same &= (len == min<size_t>(substrLen, column.lens[rows[i]] - froms[i])) && !memcmp(result.data(), column.rows[rows[i]].data() + froms[i], len);
+      }
+      auto stopTime = std::chrono::steady_clock::now();
+      return std::chrono::duration<double>(stopTime - startTime).count() * 1e9 / lookups; // ns per substr
+   };
+
+   double decompress = time([&](unsigned row, size_t from) {
+      size_t len = fsst_decompress(&column.decoder, column.compressedLens[row], column.compressedPtrs[row], buffer.size(), buffer.data());
+      len = min<size_t>(substrLen, len - from);
+      memcpy(result.data(), buffer.data() + from, len);
+      return len;
+   });
+   double range = time([&](unsigned row, size_t from) { return fsst_decompress_range(&column.decoder, column.compressedLens[row], column.compressedPtrs[row], from, from + substrLen, result.data(), 0, nullptr); });
+   double rangeCheckpoints = time([&](unsigned row, size_t from) { return fsst_decompress_range(&column.decoder, column.compressedLens[row], column.compressedPtrs[row], from, from + substrLen, result.data(), checkpoints[row].size(), checkpoints[row].data()); });
+   if (!same) {
+      cerr << "substr mismatch" << endl;
+      return false;
+   }
+   cout << "\t" << decompress << "\t" << range << "\t" << rangeCheckpoints;
+   return true;
+}
+
+/// A simple string hash (8 bytes at a time), that the compiler can inline
+static inline uint64_t hashString(size_t len, const unsigned char* str) {
+   uint64_t hash = len * 0x9E3779B97F4A7C15ull;
+   for (; len >= 8; len -= 8, str += 8) {
+      uint64_t word;
+      memcpy(&word, str, 8);
+      hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+   }
+   uint64_t word = 0;
+   memcpy(&word, str, len);
+   hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+   return hash ^ (hash >> 32);
+}
+
+/// Hash a column, decompressing batches first vs. fused with decompression
+static bool fusedTest(const string& file) {
+   Column column;
+   if (!column.load(file)) return false;
+   constexpr unsigned repeat = 10, batch = 1024;
+   size_t n = column.rows.size();
+   vector<unsigned char> buffer(column.totalLen + 8 * batch + 4096);
+   vector<size_t> batchLens(batch);
+   vector<const unsigned char*> batchPtrs(batch);
+   uint64_t hashMaterialized = 0, hashFused = 0;
+
+   auto time = [&](auto&& fn) {
+      auto startTime = std::chrono::steady_clock::now();
+      for (unsigned index = 0; index != repeat; ++index)
+         fn();
+      auto stopTime = std::chrono::steady_clock::now();
+      return std::chrono::duration<double>(stopTime - startTime).count() * 1e9 / (repeat * n); // ns per row
+   };
+
+   double materialized = time([&]() {
+      for (size_t first = 0; first < n; first += batch) {
+         size_t count = min<size_t>(batch, n - first);
+         unsigned char* writer = buffer.data();
+         for (size_t i = 0; i < count; i++) {
+            batchPtrs[i] = writer;
+            writer += batchLens[i] = fsst_decompress(&column.decoder, column.compressedLens[first + i], column.compressedPtrs[first + i], buffer.data() + buffer.size() - writer, writer);
+         }
+         for (size_t i = 0; i < count; i++)
+            hashMaterialized += hashString(batchLens[i], batchPtrs[i]);
+      }
+   });
+   double fused = time([&]() {
+      fsst::for_each_decoded(&column.decoder, n, column.compressedLens.data(), column.compressedPtrs.data(), [&](size_t, const unsigned char* str, size_t len) {
+         hashFused += hashString(len, str);
+      });
+   });
+   if (hashMaterialized != hashFused) {
+      cerr << "hash mismatch" << endl;
+      return false;
+   }
+   cout << "\t" << materialized << "\t" << fused;
+   return true;
+}
+
+/// Write a column to a file, and count the lines of the file as one string, decompressed vs. on the symbols
+static bool writeTest(const string& file) {
+   Column column, document;
+   if (!column.load(file) || !document.load(file, nullptr, 64 << 20)) return false;
+   if (document.rows.size() != 1) {
+      cerr << file << " is too large" << endl;
+      return false;
+   }
+   unsigned repeat = 1 + (200 << 20) / column.totalLen; // ~200MB per measurement
+   size_t n = column.rows.size();
+   char name[] = "/tmp/optestXXXXXX";
+   int fd = mkstemp(name);
+   if (fd < 0) {
+      cerr << "unable to create a temporary file" << endl;
+      return false;
+   }
+   unlink(name);
+
+   auto time = [&](size_t bytes, auto&& fn) {
+      auto startTime = std::chrono::steady_clock::now();
+      for (unsigned index = 0; index != repeat; ++index)
+         fn();
+      auto stopTime = std::chrono::steady_clock::now();
+      return (bytes * repeat) / std::chrono::duration<double>(stopTime - startTime).count() / (1 << 20); // MB/s
+   };
+   string expected;
+   for (auto& row : column.rows) expected += row;
+   auto check = [&]() {
+      vector<char> written(expected.size());
+      bool same = pread(fd, written.data(), written.size(), 0) == (ssize_t) written.size() && !memcmp(written.data(), expected.data(), written.size());
+      return same && !ftruncate(fd, 0);
+   };
+
+   vector<unsigned char> buffer(document.totalLen + 4096);
+   bool ok = true;
+   cout << "\t" << time(column.totalLen, [&]() {
+      unsigned char* writer = buffer.data();
+      for (size_t i = 0; i < n; i++)
+         writer += fsst_decompress(&column.decoder, column.compressedLens[i], column.compressedPtrs[i], buffer.data() + buffer.size() - writer, writer);
+      ok &= pwrite(fd, buffer.data(), writer - buffer.data(), 0) == writer - buffer.data();
+   });
+   ok &= check();
+   cout << "\t" << time(column.totalLen, [&]() {
+      lseek(fd, 0, SEEK_SET);
+      ok &= fsst::write_decoded(fd, &column.decoder, n, column.compressedLens.data(), column.compressedPtrs.data()) == (ssize_t) column.totalLen;
+   });
+   ok &= check();
+   close(fd);
+
+   size_t linesDecompressed = 0, linesSymbols = 0;
+   cout << "\t" << time(document.totalLen, [&]() {
+      size_t len = fsst_decompress(&document.decoder, document.compressedLens[0], document.compressedPtrs[0], buffer.size(), buffer.data());
+      linesDecompressed += count(buffer.data(), buffer.data() + len, '\n');
+   });
+   cout << "\t" << time(document.totalLen, [&]() {
+      fsst::symbol_iterator pieces(&document.decoder, document.compressedLens[0], document.compressedPtrs[0]);
+      const unsigned char* data;
+      size_t len;
+      while (pieces.next(data, len))
+         linesSymbols += count(data, data + len, '\n');
+   });
+   if (!ok || linesDecompressed != linesSymbols) {
+      cerr << "write or line count mismatch" << endl;
+      return false;
+   }
+   return true;
+}
+
+/// Decompress a large column with one and with multiple threads
+static bool parallelTest(const string& file) {
+   Column column;
+   if (!column.load(file)) return false;
+   size_t rows = column.rows.size(), copies = 1 + (512 << 20) / column.totalLen, n = rows * copies;
+   vector<unsigned long long> offsetsIn(n + 1), offsetsOut(n + 1), check(n + 1);
+   size_t compressedLen = column.compressedPtrs[rows - 1] + column.compressedLens[rows - 1] - column.compressed.data();
+   vector<unsigned char> dataIn(compressedLen * copies);
+   for (size_t copy = 0; copy < copies; copy++) {
+      memcpy(dataIn.data() + copy * compressedLen, column.compressed.data(), compressedLen);
+      for (size_t i = 0; i < rows; i++)
+         offsetsIn[copy * rows + i] = copy * compressedLen + (column.compressedPtrs[i] - column.compressed.data());
+   }
+   offsetsIn[n] = dataIn.size();
+   vector<unsigned char> output(column.totalLen * copies + 4096);
+
+   auto time = [&](auto&& decompress) {
+      auto startTime = std::chrono::steady_clock::now();
+      size_t done = decompress();
+      auto stopTime = std::chrono::steady_clock::now();
+      if (done != n) cerr << "output too small" << endl;
+      return (column.totalLen * copies) / std::chrono::duration<double>(stopTime - startTime).count() / (1 << 20); // MB/s
+   };
+
+   cout << "\t" << time([&]() { return fsst_decompress_offsets64(&column.decoder, n, offsetsIn.data(), dataIn.data(), output.size(), output.data(), check.data()); });
+   size_t checksum = 0;
+   for (size_t i = 0; i < output.size(); i += 4096) checksum += output[i];
+   for (unsigned threads : {1, 2, 4, 0}) {
+      memset(output.data(), 0, output.size());
+      cout << "\t" << time([&]() { return fsst_decompress_parallel64(&column.decoder, n, offsetsIn.data(), dataIn.data(), output.size(), output.data(), offsetsOut.data(), threads); });
+      size_t sum = 0;
+      for (size_t i = 0; i < output.size(); i += 4096) sum += output[i];
+      if (offsetsOut != check || sum != checksum || memcmp(output.data(), column.rows[0].data(), column.lens[0])) {
+         cerr << "parallel decompression mismatch" << endl;
+         return false;
+      }
+   }
+   return true;
+}
+
+int main(int argc, char* argv[]) {
+   if (argc < 2)
+      return -1;
+
+   string method = argv[1];
+   vector<string> files;
+   for (int index = 2; index < argc; ++index)
+      files.push_back(argv[index]);
+
+   if (method == "substring") {
+      cout << "file\tmatchC-ns\tmatchD-ns\tmatches" << endl;
+      for (auto& file : files) {
+         string name = file;
+         if (name.rfind('/') != string::npos)
+            name = name.substr(name.rfind('/') + 1);
+         cout << name;
+         if (!substringTest(file)) return 1;
+         cout << endl;
+      }
+   } else if (method == "prefix") {
+      cout << "file\tmatchC-ns\tmatchD-ns\tmatches" << endl;
+      for (auto& file : files) {
+         string name = file;
+         if (name.rfind('/') != string::npos)
+            name = name.substr(name.rfind('/') + 1);
+         cout << name;
+         if (!prefixTest(file)) return 1;
+         cout << endl;
+      }
+   } else if (method == "regex") {
+      cout << "file\tmatchC-ns\tstdregex-ns\tmatches" << endl;
+      for (auto& file : files) {
+         string name = file;
+         if (name.rfind('/') != string::npos)
+            name = name.substr(name.rfind('/') + 1);
+         cout << name;
+         if (!regexTest(file)) return 1;
+         cout << endl;
+      }
+   } else if (method == "hash") {
+      cout << "file\thashC-ns\thashD-ns\tgroupC-ns\tgroupD-ns\tgroups\tmemC\tmemD" << endl;
+      for (auto& file : files) {
+         string name = file;
+         if (name.rfind('/') != string::npos)
+            name = name.substr(name.rfind('/') + 1);
+         cout << name;
+         if (!hashTest(file)) return 1;
+         cout << endl;
+      }
+   } else if (method == "ordered") {
+      cout << "file\tfactor\tfactorOrdered\tsizeIncrease%" << endl;
+      for (auto& file : files) {
+         string name = file;
+         if (name.rfind('/') != string::npos)
+            name = name.substr(name.rfind('/') + 1);
+         cout << name;
+         if (!orderedTest(file)) return 1;
+         cout << endl;
+      }
+   } else if (method == "keys") {
+      cout << "file\tkey8C-ns\tkey8D-ns\tties8%\tkey16C-ns\tkey16D-ns\tties16%" << endl;
+      for (auto& file : files) {
+         string name = file;
+         if (name.rfind('/') != string::npos)
+            name = name.substr(name.rfind('/') + 1);
+         cout << name;
+         if (!keysTest(file)) return 1;
+         cout << endl;
+      }
+   } else if (method == "lookup") {
+      cout << "file\tp50-ns\tp99-ns\tMlookups/s\tp50I-ns\tp99I-ns\tMlookupsI/s" << endl;
+      for (auto& file : files) {
+         string name = file;
+         if (name.rfind('/') != string::npos)
+            name = name.substr(name.rfind('/') + 1);
+         cout << name;
+         if (!lookupTest(file)) return 1;
+         cout << endl;
+      }
+   } else if (method == "pairs") {
+      cout << "file\tMB/s\tpairs256-MB/s\tpairs1024-MB/s\tpairs1792-MB/s" << endl;
+      for (auto& file : files) {
+         string name = file;
+         if (name.rfind('/') != string::npos)
+            name = name.substr(name.rfind('/') + 1);
+         cout << name;
+         if (!pairsTest(file)) return 1;
+         cout << endl;
+      }
+   } else if (method == "wide") {
+      cout << "file\t4KB-MB/s\t4KBwide-MB/s\t64KB-MB/s\t64KBwide-MB/s" << endl;
+      for (auto& file : files) {
+         string name = file;
+         if (name.rfind('/') != string::npos)
+            name = name.substr(name.rfind('/') + 1);
+         cout << name;
+         if (!wideTest(file)) return 1;
+         cout << endl;
+      }
+   } else if (method == "stream") {
+      cout << "file\tMB/s\tstream64KB-MB/s\tstream4KB-MB/s" << endl;
+      for (auto& file : files) {
+         string name = file;
+         if (name.rfind('/') != string::npos)
+            name = name.substr(name.rfind('/') + 1);
+         cout << name;
+         if (!streamTest(file)) return 1;
+         cout << endl;
+      }
+   } else if (method == "range") {
+      cout << "file\tdecompress-ns\trange-ns\trangeCheckpoints-ns" << endl;
+      for (auto& file : files) {
+         string name = file;
+         if (name.rfind('/') != string::npos)
+            name = name.substr(name.rfind('/') + 1);
+         cout << name;
+         if (!rangeTest(file)) return 1;
+         cout << endl;
+      }
+   } else if (method == "fused") {
+      cout << "file\tmaterialized-ns\tfused-ns" << endl;
+      for (auto& file : files) {
+         string name = file;
+         if (name.rfind('/') != string::npos)
+            name = name.substr(name.rfind('/') + 1);
+         cout << name;
+         if (!fusedTest(file)) return 1;
+         cout << endl;
+      }
+   } else if (method == "write") {
+      cout << "file\twrite-MB/s\twriteStream-MB/s\tlines-MB/s\tlinesSymbols-MB/s" << endl;
+      for (auto& file : files) {
+         string name = file;
+         if (name.rfind('/') != string::npos)
+            name = name.substr(name.rfind('/') + 1);
+         cout << name;
+         if (!writeTest(file)) return 1;
+         cout << endl;
+      }
+   } else if (method == "parallel") {
+      cout << "file\tMB/s\tthreads1-MB/s\tthreads2-MB/s\tthreads4-MB/s\tthreadsAll-MB/s" << endl;
+      for (auto& file : files) {
+         string name = file;
+         if (name.rfind('/') != string::npos)
+            name = name.substr(name.rfind('/') + 1);
+         cout << name;
+         if (!parallelTest(file)) return 1;
+         cout << endl;
+      }
+   } else {
+      cerr << "unknown method " << method << endl;
+      return 1;
+   }
+}